@@ -1,16 +1,73 @@
 #include "PyPlotter.hpp"
+#include "profiler.hpp"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <thread>
 #include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <stdlib.h>
 
+namespace {
+
+const std::uint32_t kFrameMagic = 0x544C5043;  // "CPLT" in little-endian byte order
+const std::uint16_t kFramePoints = 1;
+const std::uint16_t kFrameStop = 2;
+const std::uint16_t kFrameSnapshot = 3;
+const std::size_t kMaxFramePoints = 2048;      // 48 KB of records, below the default pipe capacity
+const auto kCoalesce = std::chrono::milliseconds(20);
+const auto kSnapshotInterval = std::chrono::milliseconds(100);  // Twice the plot window's redraw rate
+const int kStopDeadlineMs = 2000;              // How long stopPlotter waits for a stalled plot
+
+struct FrameHeader {
+    std::uint32_t magic;
+    std::uint16_t type;
+    std::uint16_t reserved;
+    std::uint32_t count;
+    std::uint32_t dropped;
+};
+static_assert(sizeof(FrameHeader) == 16, "Plot frame header must stay 16 bytes");
+
+struct FrameRecord {
+    double x;
+    double y;
+    std::uint32_t series;
+    std::uint32_t reserved;
+};
+static_assert(sizeof(FrameRecord) == 24, "Plot frame record must stay 24 bytes");
+
+// Serialize one frame
+std::string makeFrame(std::uint16_t type, const std::vector<PlotPoint>& points, std::uint32_t dropped) {
+    FrameHeader h{kFrameMagic, type, 0, static_cast<std::uint32_t>(points.size()), dropped};
+    std::string frame(sizeof(h) + points.size() * sizeof(FrameRecord), '\0');
+    std::memcpy(frame.data(), &h, sizeof(h));
+    char* out = frame.data() + sizeof(h);
+    for (const auto& p : points) {
+        FrameRecord r{p.x, p.y, p.series, 0};
+        std::memcpy(out, &r, sizeof(r));
+        out += sizeof(r);
+    }
+    return frame;
+}
+
+} // namespace
+
 // Constructor initializes the plotter state
-PyPlotter::PyPlotter() : running(false) {}
+PyPlotter::PyPlotter(std::size_t capacity, PlotBackpressure policy)
+    : pid(-1), plotter_stdin(-1), running(false), policy(policy), ring(capacity < 2 ? 2 : capacity),
+      head(0), count(0), dropped(0), droppedPending(0), stopping(false), broken(false),
+      decimationBuckets(0), dirty(false) {}
+
+void PyPlotter::enableDecimation(std::size_t buckets) {
+    decimationBuckets = buckets;
+}
 
 // Start Python-based plotting script as a child process
 void PyPlotter::startPython() {
@@ -41,32 +98,169 @@ void PyPlotter::startPython() {
         std::cerr << "Exec failed\n";
         exit(1);
     } else {
-        // Parent process
+        // Parent process: writes must never block, and a closed plot window must not kill us
         close(pipefd[0]);
         plotter_stdin = pipefd[1];
+        fcntl(plotter_stdin, F_SETFL, fcntl(plotter_stdin, F_GETFL) | O_NONBLOCK);
+        fcntl(plotter_stdin, F_SETFD, FD_CLOEXEC);
+        signal(SIGPIPE, SIG_IGN);
+
+        head = count = 0;
+        droppedPending = 0;
+        stopping = broken = dirty = false;
+        decimators.clear();
         running = true;
+        writer = std::thread(&PyPlotter::writerLoop, this);
+    }
+}
+
+// Free one slot; returns false if the incoming point itself should be dropped
+bool PyPlotter::makeRoom() {
+    switch (policy) {
+    case PlotBackpressure::DropNewest:
+        return false;
+    case PlotBackpressure::DropOldest:
+        head = (head + 1) % ring.size();
+        --count;
+        ++dropped;
+        ++droppedPending;
+        return true;
+    case PlotBackpressure::Decimate: {
+        // Keep the odd positions so the newest queued point survives
+        std::vector<PlotPoint> kept;
+        kept.reserve(count / 2 + 1);
+        for (std::size_t i = 1; i < count; i += 2) kept.push_back(ring[(head + i) % ring.size()]);
+        std::size_t lost = count - kept.size();
+        std::copy(kept.begin(), kept.end(), ring.begin());
+        head = 0;
+        count = kept.size();
+        dropped += lost;
+        droppedPending += static_cast<std::uint32_t>(lost);
+        return true;
+    }
     }
+    return false;
 }
 
-// Send a single numeric data point to the Python plotter
-void PyPlotter::sendPoint(double value) {
+// Queue a data point for the Python plotter
+void PyPlotter::sendPoint(double x, double y, std::uint32_t series) {
     if (!running) return;
-    std::string data = std::to_string(value) + "\n";
-    (void)write(plotter_stdin, data.c_str(), data.size());
-    fsync(plotter_stdin);
+    bool fullFrame;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (decimationBuckets && !broken) {
+            decimators.try_emplace(series, decimationBuckets).first->second.add(x, y);
+            dirty = true;
+            return;
+        }
+        if (broken || (count == ring.size() && !makeRoom())) {
+            ++dropped;
+            ++droppedPending;
+            return;
+        }
+        ring[(head + count) % ring.size()] = {x, y, series};
+        ++count;
+        fullFrame = count >= kMaxFramePoints;
+    }
+    if (fullFrame) wake.notify_one();
+}
+
+// Write with poll() waits; -1 deadline waits as long as the plotter is running
+bool PyPlotter::writeFrame(const std::string& frame, int deadlineMs) {
+    auto start = std::chrono::steady_clock::now();
+    std::size_t sent = 0;
+    while (sent < frame.size()) {
+        ssize_t n = write(plotter_stdin, frame.data() + sent, frame.size() - sent);
+        if (n > 0) {
+            sent += static_cast<std::size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) return false;  // EPIPE: plot process gone
+
+        int waited = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                          std::chrono::steady_clock::now() - start).count());
+        if (deadlineMs >= 0 && waited >= deadlineMs) return false;
+        pollfd pfd{plotter_stdin, POLLOUT, 0};
+        poll(&pfd, 1, 100);
+        if (pfd.revents & (POLLERR | POLLHUP)) return false;
+
+        // Give up on a stuck plot once stopping, even mid-frame
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping && deadlineMs < 0) deadlineMs = waited + kStopDeadlineMs;
+    }
+    return true;
+}
+
+// Drain the ring in batches of up to kMaxFramePoints, one write per frame,
+// or with decimation send a snapshot of every series whenever points were added
+void PyPlotter::writerLoop() {
+    std::vector<PlotPoint> batch;
+    batch.reserve(kMaxFramePoints);
+    while (true) {
+        std::uint32_t lost;
+        bool done;
+        std::uint16_t type = kFramePoints;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            batch.clear();
+            if (decimationBuckets) {
+                wake.wait_for(lock, kSnapshotInterval, [&] { return stopping; });
+                if (dirty) {
+                    for (const auto& [series, d] : decimators) d.snapshot(batch, series);
+                    dirty = false;
+                    type = kFrameSnapshot;
+                }
+            } else {
+                wake.wait_for(lock, kCoalesce, [&] { return stopping || count >= kMaxFramePoints; });
+                while (count > 0 && batch.size() < kMaxFramePoints) {
+                    batch.push_back(ring[head]);
+                    head = (head + 1) % ring.size();
+                    --count;
+                }
+            }
+            lost = droppedPending;
+            droppedPending = 0;
+            done = stopping && count == 0;
+        }
+
+        if (broken) {
+            std::lock_guard<std::mutex> lock(mutex);
+            dropped += batch.size();
+        } else if (!batch.empty() || lost) {
+            ScopedTimer t("plot.write_frame");
+            if (!writeFrame(makeFrame(type, batch, lost), -1)) {
+                std::lock_guard<std::mutex> lock(mutex);
+                broken = true;
+            }
+            profileCount("plot.frames");
+        }
+        if (lost) profileCount("plot.dropped", lost);
+        if (done) break;
+    }
+    if (!broken) writeFrame(makeFrame(kFrameStop, {}, 0), kStopDeadlineMs);
 }
 
 // Stop the plotting process cleanly
 void PyPlotter::stopPlotter() {
     if (!running) return;
-    (void)write(plotter_stdin, "STOP\n", 5);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (writer.joinable()) writer.join();
     close(plotter_stdin);
     waitpid(pid, NULL, 0);
     running = false;
 }
 
+std::uint64_t PyPlotter::droppedPoints() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return dropped;
+}
+
 // Destructor ensures plotter process is terminated
 PyPlotter::~PyPlotter() {
     if (running) stopPlotter();
 }
-
@@ -1,22 +1,79 @@
 #ifndef __PYPLOTTER_HPP__
 #define __PYPLOTTER_HPP__
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+#include <sys/types.h>
+#include "plot_decimator.hpp"
 
-// PyPlotter class manages real-time plotting using a Python subprocess
+// What sendPoint does when the plot process falls behind and the queue is full
+enum class PlotBackpressure {
+    DropNewest,   // Discard the incoming point
+    DropOldest,   // Overwrite the oldest queued point
+    Decimate      // Keep every other queued point, halving the backlog
+};
+
+// Wire format to plotter.py (host byte order), one frame per batch:
+//   uint32 magic 'CPLT', uint16 type (1 = points, 2 = stop, 3 = snapshot), uint16 reserved,
+//   uint32 count, uint32 dropped (points lost since the previous frame),
+//   then count records of { double x, double y, uint32 series, uint32 reserved }
+// A snapshot frame replaces everything plotted so far for the series it contains.
+
+// PyPlotter class manages real-time plotting using a Python subprocess.
+// Points go into an in-process ring buffer; a background thread drains it and
+// writes coalesced binary frames to a non-blocking pipe, so a stalled plot
+// window never blocks the measurement loop.
 class PyPlotter {
 public:
-    PyPlotter();             // Constructor
+    explicit PyPlotter(std::size_t capacity = 16384,
+                       PlotBackpressure policy = PlotBackpressure::Decimate);
     ~PyPlotter();            // Destructor (ensures subprocess cleanup)
 
-    void startPython();      // Launch plotting subprocess
-    void sendPoint(double); // Send new data point to the plot
-    void stopPlotter();      // Stop and close the plotting subprocess
+    void startPython();      // Launch plotting subprocess and the writer thread
+
+    // Send decimated snapshots (at most 8 x buckets points per series) instead of
+    // every point, so long streams stay cheap to draw. Call before startPython().
+    void enableDecimation(std::size_t buckets = 1000);
+
+    void sendPoint(double x, double y, std::uint32_t series = 0);  // Queue a point (never blocks on the pipe)
+    void stopPlotter();      // Send queued points, then stop and close the plotting subprocess
+
+    // Points discarded so far because of backpressure or a dead plot process
+    std::uint64_t droppedPoints() const;
 
 private:
+    // Writer thread: batch queued points into frames and write them out
+    void writerLoop();
+
+    // Write a whole frame to the non-blocking pipe, waiting for space until deadlineMs
+    bool writeFrame(const std::string& frame, int deadlineMs);
+
+    // Make room in the full ring according to the backpressure policy (mutex held)
+    bool makeRoom();
+
     pid_t pid;               // Process ID of the child process
     int plotter_stdin;       // File descriptor to send data to plotter
     bool running;            // Track if the plotter is active
+
+    PlotBackpressure policy;
+    std::vector<PlotPoint> ring;     // Fixed-size queue between sendPoint and the writer
+    std::size_t head;                // Oldest queued point
+    std::size_t count;               // Number of queued points
+    std::uint64_t dropped;           // Total points discarded
+    std::uint32_t droppedPending;    // Discarded since the last frame
+    bool stopping;
+    bool broken;                     // Plot process gone, discard everything
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::thread writer;
+
+    std::size_t decimationBuckets;   // 0 = stream every point
+    std::map<std::uint32_t, MinMaxDecimator> decimators;
+    bool dirty;                      // Points added since the last snapshot
 };
 
 #endif
-
@@ -0,0 +1,382 @@
+#include "analysis.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+// Accumulator lanes of the reductions; independent partial sums let the
+// compiler pack them into vector registers without reassociating anything
+constexpr std::size_t kLanes = 4;
+
+static void requireSameLength(std::size_t a, std::size_t b, const char* what) {
+    if (a != b) throw std::runtime_error(std::string(what) + ": column lengths differ");
+}
+
+// The kernels take restrict pointers, so the loops vectorize without runtime overlap checks
+
+static void divideKernel(const double* __restrict v, const double* __restrict i, double* __restrict out,
+                         std::size_t n, double minCurrent) {
+    for (std::size_t k = 0; k < n; ++k) {
+        bool ok = std::fabs(i[k]) > minCurrent;
+        double q = v[k] / (ok ? i[k] : 1.0);
+        out[k] = ok ? q : 0.0;
+    }
+}
+
+void resistances(std::span<const double> v, std::span<const double> i, std::span<double> out, double minCurrent) {
+    requireSameLength(v.size(), i.size(), "resistances");
+    requireSameLength(v.size(), out.size(), "resistances");
+    divideKernel(v.data(), i.data(), out.data(), v.size(), minCurrent);
+}
+
+ColumnStats columnStats(std::span<const double> x) {
+    ColumnStats s;
+    std::size_t n = x.size();
+    s.count = n;
+    if (n == 0) return s;
+
+    const double* p = x.data();
+    double sum[kLanes] = {}, lo[kLanes], hi[kLanes];
+    for (std::size_t j = 0; j < kLanes; ++j) lo[j] = hi[j] = p[0];
+    std::size_t k = 0;
+    for (; k + kLanes <= n; k += kLanes) {
+        for (std::size_t j = 0; j < kLanes; ++j) {
+            double v = p[k + j];
+            sum[j] += v;
+            lo[j] = v < lo[j] ? v : lo[j];
+            hi[j] = v > hi[j] ? v : hi[j];
+        }
+    }
+    for (; k < n; ++k) {
+        sum[0] += p[k];
+        lo[0] = std::min(lo[0], p[k]);
+        hi[0] = std::max(hi[0], p[k]);
+    }
+    s.min = std::min({lo[0], lo[1], lo[2], lo[3]});
+    s.max = std::max({hi[0], hi[1], hi[2], hi[3]});
+    s.mean = (sum[0] + sum[1] + sum[2] + sum[3]) / n;
+
+    // Second pass around the mean: no cancellation for small spreads on large offsets
+    double sq[kLanes] = {};
+    for (k = 0; k + kLanes <= n; k += kLanes) {
+        for (std::size_t j = 0; j < kLanes; ++j) {
+            double d = p[k + j] - s.mean;
+            sq[j] += d * d;
+        }
+    }
+    for (; k < n; ++k) sq[0] += (p[k] - s.mean) * (p[k] - s.mean);
+    s.stddev = n > 1 ? std::sqrt((sq[0] + sq[1] + sq[2] + sq[3]) / (n - 1)) : 0.0;
+    return s;
+}
+
+// 1 inside [lo, hi], 0 outside; a weight instead of a branch
+static inline double inRange(double x, double lo, double hi) {
+    return x >= lo ? (x <= hi ? 1.0 : 0.0) : 0.0;
+}
+
+LineFit fitLine(std::span<const double> x, std::span<const double> y, double lo, double hi) {
+    requireSameLength(x.size(), y.size(), "fitLine");
+    const double* px = x.data();
+    const double* py = y.data();
+    std::size_t n = x.size();
+    LineFit fit;
+    if (n < 2) return fit;
+
+    // One pass over values shifted by the middle sample: it lies inside the data,
+    // so the sums stay small next to the spread and nothing cancels
+    double x0 = px[n / 2], y0 = py[n / 2];
+    double cnt[kLanes] = {}, sx[kLanes] = {}, sy[kLanes] = {};
+    double sxx[kLanes] = {}, sxy[kLanes] = {}, syy[kLanes] = {};
+    std::size_t k = 0;
+    if (lo == -kInfinity && hi == kInfinity) {
+        // Every point counts: no weights, and the count is known
+        for (; k + kLanes <= n; k += kLanes) {
+            for (std::size_t j = 0; j < kLanes; ++j) {
+                double dx = px[k + j] - x0;
+                double dy = py[k + j] - y0;
+                sx[j] += dx;
+                sy[j] += dy;
+                sxx[j] += dx * dx;
+                sxy[j] += dx * dy;
+                syy[j] += dy * dy;
+            }
+        }
+        cnt[0] = static_cast<double>(k);
+    }
+    for (; k + kLanes <= n; k += kLanes) {
+        for (std::size_t j = 0; j < kLanes; ++j) {
+            double w = inRange(px[k + j], lo, hi);
+            double dx = w * (px[k + j] - x0);
+            double dy = w * (py[k + j] - y0);
+            cnt[j] += w;
+            sx[j] += dx;
+            sy[j] += dy;
+            sxx[j] += dx * dx;
+            sxy[j] += dx * dy;
+            syy[j] += dy * dy;
+        }
+    }
+    for (; k < n; ++k) {
+        double w = inRange(px[k], lo, hi);
+        double dx = w * (px[k] - x0);
+        double dy = w * (py[k] - y0);
+        cnt[0] += w;
+        sx[0] += dx;
+        sy[0] += dy;
+        sxx[0] += dx * dx;
+        sxy[0] += dx * dy;
+        syy[0] += dy * dy;
+    }
+    auto total = [](const double (&a)[kLanes]) { return a[0] + a[1] + a[2] + a[3]; };
+    double m = total(cnt);
+    fit.count = static_cast<std::size_t>(m);
+    if (fit.count < 2) return fit;
+    double mx = total(sx) / m, my = total(sy) / m;
+    double Sxx = total(sxx) - m * mx * mx;
+    double Sxy = total(sxy) - m * mx * my;
+    double Syy = total(syy) - m * my * my;
+    if (Sxx <= 0) return fit;   // All x equal: no slope
+
+    fit.slope = Sxy / Sxx;
+    fit.intercept = y0 + my - fit.slope * (x0 + mx);
+    fit.r2 = Syy > 0 ? std::min(Sxy * Sxy / (Sxx * Syy), 1.0) : 1.0;
+    fit.residual = fit.count > 2 ? std::sqrt(std::max(Syy - fit.slope * Sxy, 0.0) / (fit.count - 2)) : 0.0;
+    return fit;
+}
+
+static void centralDifferenceKernel(const double* __restrict x, const double* __restrict y, double* __restrict out,
+                                    std::size_t n) {
+    for (std::size_t k = 1; k + 1 < n; ++k) {
+        double dx = x[k + 1] - x[k - 1];
+        double dy = y[k + 1] - y[k - 1];
+        double q = dy / (dx != 0.0 ? dx : 1.0);
+        out[k] = dx != 0.0 ? q : kNaN;
+    }
+}
+
+void derivative(std::span<const double> x, std::span<const double> y, std::span<double> out) {
+    requireSameLength(x.size(), y.size(), "derivative");
+    requireSameLength(x.size(), out.size(), "derivative");
+    std::size_t n = x.size();
+    if (n < 2) {
+        std::fill(out.begin(), out.end(), kNaN);
+        return;
+    }
+    auto slope = [&](std::size_t a, std::size_t b) {
+        double dx = x[b] - x[a];
+        return dx != 0.0 ? (y[b] - y[a]) / dx : kNaN;
+    };
+    centralDifferenceKernel(x.data(), y.data(), out.data(), n);
+    out[0] = slope(0, 1);
+    out[n - 1] = slope(n - 2, n - 1);
+}
+
+static void reciprocalKernel(double* __restrict g, std::size_t n) {
+    for (std::size_t k = 0; k < n; ++k) {
+        bool ok = g[k] != 0.0;
+        double r = 1.0 / (ok ? g[k] : 1.0);
+        g[k] = ok ? r : 0.0;
+    }
+}
+
+void differentialResistance(std::span<const double> v, std::span<const double> i, std::span<double> out) {
+    derivative(v, i, out);
+    reciprocalKernel(out.data(), out.size());
+}
+
+// out[k] += x[k]; called once per window offset with x advanced by that offset
+static void addShiftedKernel(const double* __restrict x, double* __restrict out, std::size_t n) {
+    for (std::size_t k = 0; k < n; ++k) out[k] += x[k];
+}
+
+static void scaleKernel(double* __restrict out, std::size_t n, double factor) {
+    for (std::size_t k = 0; k < n; ++k) out[k] *= factor;
+}
+
+// Mean of x[a, b) for the shrunk windows at both ends
+static double rangeMean(std::span<const double> x, std::size_t a, std::size_t b) {
+    double sum = 0.0;
+    for (std::size_t k = a; k < b; ++k) sum += x[k];
+    return sum / (b - a);
+}
+
+void movingAverage(std::span<const double> x, std::span<double> out, std::size_t window) {
+    requireSameLength(x.size(), out.size(), "movingAverage");
+    std::size_t n = x.size();
+    std::size_t half = window / 2;
+    if (n == 0) return;
+    if (half == 0) {
+        std::copy(x.begin(), x.end(), out.begin());
+        return;
+    }
+
+    // Interior: every output sees the full window, summed offset by offset
+    if (n > 2 * half) {
+        std::size_t m = n - 2 * half;
+        double* inner = out.data() + half;
+        std::fill(inner, inner + m, 0.0);
+        for (std::size_t s = 0; s <= 2 * half; ++s) addShiftedKernel(x.data() + s, inner, m);
+        scaleKernel(inner, m, 1.0 / (2 * half + 1));
+    }
+    for (std::size_t k = 0; k < std::min(half, n); ++k) {
+        out[k] = rangeMean(x, 0, std::min(n, k + half + 1));
+        std::size_t r = n - 1 - k;
+        if (r >= half) out[r] = rangeMean(x, r - half, n);
+    }
+}
+
+// Values of a sliding window kept in order: one memmove per step, median in O(1)
+// and the median absolute deviation in O(window), no sorting per point
+class SortedWindow {
+public:
+    explicit SortedWindow(std::size_t capacity) { values_.reserve(capacity); }
+
+    void insert(double v) { values_.insert(std::upper_bound(values_.begin(), values_.end(), v), v); }
+    void erase(double v) { values_.erase(std::lower_bound(values_.begin(), values_.end(), v)); }
+    std::size_t size() const { return values_.size(); }
+
+    // Same convention as median(): mean of the two middle values for an even count
+    double median() const {
+        std::size_t mid = values_.size() / 2;
+        return values_.size() % 2 ? values_[mid] : (values_[mid - 1] + values_[mid]) / 2.0;
+    }
+
+    // Median of |v - center|: the deviations grow outwards from center on both
+    // sides, so merging the two sides yields them in order
+    double medianDeviation(double center) const {
+        std::size_t n = values_.size();
+        std::size_t right = std::lower_bound(values_.begin(), values_.end(), center) - values_.begin();
+        std::size_t left = right;   // Next candidate on the left is values_[left - 1]
+        double prev = 0.0, cur = 0.0;
+        for (std::size_t taken = 0; taken <= n / 2; ++taken) {
+            prev = cur;
+            bool takeLeft = right == n || (left > 0 && center - values_[left - 1] <= values_[right] - center);
+            cur = takeLeft ? center - values_[--left] : values_[right++] - center;
+        }
+        return n % 2 ? cur : (prev + cur) / 2.0;
+    }
+
+private:
+    std::vector<double> values_;
+};
+
+// Slide a centered window (shrinking at both ends) over x, calling fn(k, window)
+template <typename Fn>
+static void slideWindow(std::span<const double> x, std::size_t window, Fn fn) {
+    std::size_t n = x.size();
+    std::size_t half = window / 2;
+    SortedWindow win(2 * half + 1);
+    std::size_t a = 0, b = 0;
+    for (std::size_t k = 0; k < n; ++k) {
+        std::size_t end = std::min(n, k + half + 1);
+        std::size_t begin = k >= half ? k - half : 0;
+        while (b < end) win.insert(x[b++]);
+        while (a < begin) win.erase(x[a++]);
+        fn(k, win);
+    }
+}
+
+void movingMedian(std::span<const double> x, std::span<double> out, std::size_t window) {
+    requireSameLength(x.size(), out.size(), "movingMedian");
+    slideWindow(x, window, [&](std::size_t k, const SortedWindow& win) { out[k] = win.median(); });
+}
+
+std::size_t flagOutliers(std::span<const double> x, std::span<std::uint8_t> flags, std::size_t window,
+                         double threshold) {
+    requireSameLength(x.size(), flags.size(), "flagOutliers");
+    std::size_t flagged = 0;
+    slideWindow(x, window, [&](std::size_t k, const SortedWindow& win) {
+        double center = win.median();
+        double mad = win.medianDeviation(center);
+        bool out = win.size() >= 3 && mad > 0 && 0.6745 * std::fabs(x[k] - center) / mad > threshold;
+        flags[k] = out ? 1 : 0;
+        flagged += out;
+    });
+    return flagged;
+}
+
+IvSummary analyzeIv(std::span<const double> voltage, std::span<const double> current, const AnalysisOptions& options) {
+    ScopedTimer t("analysis.run");
+    requireSameLength(voltage.size(), current.size(), "analyzeIv");
+    IvSummary s;
+    std::size_t n = voltage.size();
+    s.points = n;
+    s.voltage = columnStats(voltage);
+    s.current = columnStats(current);
+
+    std::vector<double> work(n), smooth(n);
+    resistances(voltage, current, work, options.minCurrent);
+    s.resistance = columnStats(work);
+
+    s.fit = fitLine(voltage, current, options.fitLo, options.fitHi);
+    if (s.fit.slope != 0.0) s.fitResistance = 1.0 / s.fit.slope;
+
+    // Noise: what the moving median does not explain, away from the shrunk windows
+    // at both ends (their median lags a sloped curve); spikes are counted separately
+    movingMedian(current, smooth, options.window);
+    for (std::size_t k = 0; k < n; ++k) work[k] = current[k] - smooth[k];
+    std::size_t half = options.window / 2;
+    std::span<const double> residual(work);
+    s.noise = columnStats(n > 2 * half ? residual.subspan(half, n - 2 * half) : residual).stddev;
+
+    // Zero-bias resistance from a local fit: the window of points around the one closest to 0 V
+    if (n >= 2) {
+        std::size_t zero = 0;
+        for (std::size_t k = 1; k < n; ++k)
+            if (std::fabs(voltage[k]) < std::fabs(voltage[zero])) zero = k;
+        std::size_t w = std::min(n, std::max<std::size_t>(options.window, 2));
+        std::size_t a = std::min(zero >= w / 2 ? zero - w / 2 : 0, n - w);
+        LineFit local = fitLine(voltage.subspan(a, w), current.subspan(a, w));
+        if (local.slope != 0.0) s.zeroBiasResistance = 1.0 / local.slope;
+    }
+
+    std::vector<std::uint8_t> flags(n);
+    s.outliers = flagOutliers(current, flags, options.outlierWindow, options.outlierThreshold);
+    s.ok = true;
+    return s;
+}
+
+IvSummary analyzeIv(const DataManager& data, const AnalysisOptions& options) {
+    return analyzeIv(data.voltages(), data.currents(), options);
+}
+
+// Workers pull the next file index until all are done (as plot_render does)
+std::vector<IvSummary> analyzeRunFiles(const std::vector<std::string>& paths, unsigned threads,
+                                       const AnalysisOptions& options) {
+    std::vector<IvSummary> results(paths.size());
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t i; (i = next++) < paths.size();) {
+            try {
+                RunFileReader run(paths[i]);
+                results[i] = analyzeIv(run.f64("voltage"), run.f64("current"), options);
+            } catch (const std::exception& e) {
+                results[i].error = e.what();
+            }
+            results[i].source = paths[i];
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < std::min<std::size_t>(threads, paths.size()); ++t) pool.emplace_back(work);
+    work();
+    for (auto& t : pool) t.join();
+    return results;
+}
+
+void writeSummaryCsv(std::ostream& out, const std::vector<IvSummary>& summaries) {
+    out << "Run,Points,Vmin,Vmax,Imin,Imax,Rmean,Rstd,Slope,Intercept,R2,Rfit,R0,Noise,Outliers,Error\n";
+    char line[512];
+    for (const auto& s : summaries) {
+        std::snprintf(line, sizeof(line), ",%zu,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%zu,",
+                      s.points, s.voltage.min, s.voltage.max, s.current.min, s.current.max, s.resistance.mean,
+                      s.resistance.stddev, s.fit.slope, s.fit.intercept, s.fit.r2, s.fitResistance,
+                      s.zeroBiasResistance, s.noise, s.outliers);
+        std::string error = s.error;
+        std::replace(error.begin(), error.end(), ',', ';');
+        out << s.source << line << error << "\n";
+    }
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "data_manager.hpp"
+#include "run_file.hpp"
+
+// I-V post-processing over column spans: DataManager columns or the mapped
+// columns of a run file, with no copies and no CSV in between.
+//
+// The elementwise kernels and reductions are straight loops over contiguous
+// doubles with no calls or data-dependent branches in the body, so g++
+// vectorizes them with the Makefile's ANALYSIS_FLAGS (selects instead of ifs,
+// reductions split over independent accumulators because FP addition may not
+// be reordered). Inputs must not overlap outputs. Non-finite inputs are not
+// filtered: run columns hold measured values, only setVoltage may be NaN.
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+constexpr double kInfinity = std::numeric_limits<double>::infinity();
+
+// out[k] = v[k] / i[k], or 0 where |i[k]| <= minCurrent (as DataManager::resistance)
+void resistances(std::span<const double> v, std::span<const double> i, std::span<double> out,
+                 double minCurrent = 0.0);
+
+// Count, extremes, mean and sample standard deviation of one column
+struct ColumnStats {
+    std::size_t count = 0;
+    double min = kNaN;
+    double max = kNaN;
+    double mean = kNaN;
+    double stddev = kNaN;     // n - 1; 0 below two values
+};
+ColumnStats columnStats(std::span<const double> x);
+
+// Least-squares line y = slope * x + intercept
+struct LineFit {
+    std::size_t count = 0;    // Points used
+    double slope = kNaN;
+    double intercept = kNaN;
+    double r2 = kNaN;         // Coefficient of determination
+    double residual = kNaN;   // Standard deviation of the residuals (n - 2)
+};
+
+// Fit the points with lo <= x <= hi (all by default) in one pass; sums are
+// taken around a sample of the data, so offsets like a 1 V bias with nA
+// currents do not cancel out. That shift and the r2 sums cost what
+// vectorizing saves: the full-range fit runs at the speed of plain sums,
+// a range adds the weights on top.
+LineFit fitLine(std::span<const double> x, std::span<const double> y, double lo = -kInfinity,
+                double hi = kInfinity);
+
+// Numerical dy/dx on a non-uniform grid: central differences inside, one-sided
+// at both ends; NaN where two neighbours share the same x
+void derivative(std::span<const double> x, std::span<const double> y, std::span<double> out);
+
+// Differential resistance dV/dI: 1 / (dI/dV), 0 where the conductance is 0
+void differentialResistance(std::span<const double> v, std::span<const double> i, std::span<double> out);
+
+// Centered moving average over `window` points (odd; shrinks at both ends)
+void movingAverage(std::span<const double> x, std::span<double> out, std::size_t window);
+
+// Centered moving median (odd window, shrinks at both ends); removes spikes without smearing steps
+void movingMedian(std::span<const double> x, std::span<double> out, std::size_t window);
+
+// Hampel outlier flags: flags[k] = 1 where the modified z-score of x[k] within its
+// window, 0.6745 |x - median| / MAD, exceeds threshold (the rule of rejectOutliers).
+// A short window estimates MAD poorly, hence a stricter default than its 3.5
+// (about 0.1 % false flags on Gaussian noise). Returns the number flagged;
+// windows with MAD 0 flag nothing.
+std::size_t flagOutliers(std::span<const double> x, std::span<std::uint8_t> flags, std::size_t window = 21,
+                         double threshold = 5.0);
+
+// Characterization settings for analyzeIv / analyzeRunFiles
+struct AnalysisOptions {
+    double fitLo = -kInfinity;     // Voltage range of the linear fit
+    double fitHi = kInfinity;
+    double minCurrent = 0.0;       // Currents at or below this give R = 0
+    std::size_t window = 7;        // Smoothing and zero-bias fit window (points)
+    std::size_t outlierWindow = 21;
+    double outlierThreshold = 5.0;
+};
+
+// Summary of one I-V sweep
+struct IvSummary {
+    std::string source;            // Run file path (empty for in-memory data)
+    bool ok = false;
+    std::string error;             // Set when ok is false
+    std::size_t points = 0;
+    ColumnStats voltage;
+    ColumnStats current;
+    ColumnStats resistance;        // Of the recomputed V/I column
+    LineFit fit;                   // I against V over the fit range
+    double fitResistance = kNaN;   // 1 / fit slope
+    double zeroBiasResistance = kNaN;   // dV/dI fitted over `window` points around 0 V
+    double noise = kNaN;           // Standard deviation of current minus its moving median
+    std::size_t outliers = 0;      // Current readings flagged by flagOutliers
+};
+
+// Characterize one sweep from its voltage and current columns
+IvSummary analyzeIv(std::span<const double> voltage, std::span<const double> current,
+                    const AnalysisOptions& options = {});
+IvSummary analyzeIv(const DataManager& data, const AnalysisOptions& options = {});
+
+// Map and characterize many run files on `threads` workers (0: all cores);
+// results are in input order, a file that fails only marks its own summary
+std::vector<IvSummary> analyzeRunFiles(const std::vector<std::string>& paths, unsigned threads = 0,
+                                       const AnalysisOptions& options = {});
+
+// CSV table of summaries, one row per run
+void writeSummaryCsv(std::ostream& out, const std::vector<IvSummary>& summaries);
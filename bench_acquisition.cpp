@@ -0,0 +1,318 @@
+// Benchmark: acquisition path throughput and latency.
+//
+// Drives MeasurementManager (sendCommand, measureAverage, getBasicMeasurement,
+// bulk array reads) and full resistance sweeps against a local SCPI endpoint.
+// Recorded sweep traffic is also replayed without a socket (replay.* cases) to
+// time the parsing and storage path on its own.
+// By default each scenario starts an in-process simulator with the given
+// network latency; --port targets an already running instrument or scpi_sim.
+//
+// Results are printed as JSON (points/s, commands/s, p50/p99/max latency).
+// With --baseline FILE every metric is compared against an earlier run and
+// regressions beyond --threshold (default 0.15) make the program exit with 1.
+// Latency changes smaller than --min-delta-us (default 50) are treated as noise.
+//
+// Usage: ./bench_acquisition [--quick] [--port N] [--host IP] [--out FILE]
+//                            [--baseline FILE] [--threshold F] [--min-delta-us US]
+#include "measurement_manager.hpp"
+#include "data_manager.hpp"
+#include "scpi_simulator.hpp"
+#include "sweep.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+// Summary of one benchmark case
+struct Result {
+    std::string name;
+    std::string unit;          // "commands" or "points"
+    std::size_t ops = 0;
+    double seconds = 0.0;
+    double p50 = 0.0, p99 = 0.0, max = 0.0;   // Per-op latency in microseconds
+
+    double rate() const { return seconds > 0 ? ops / seconds : 0.0; }
+};
+
+// Where the benchmark connects
+struct Endpoint {
+    std::string host = "127.0.0.1";
+    int port = 0;              // 0 = start an in-process simulator per scenario
+};
+
+// Percentile of an already sorted sample
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::size_t idx = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+// Time op() count times, recording every call's latency
+static Result measure(const std::string& name, const std::string& unit, std::size_t count,
+                      std::size_t opsPerCall, const std::function<void()>& op) {
+    std::vector<double> lat;
+    lat.reserve(count);
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        auto t0 = Clock::now();
+        op();
+        lat.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+    }
+    Result r;
+    r.name = name;
+    r.unit = unit;
+    r.ops = count * opsPerCall;
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::sort(lat.begin(), lat.end());
+    r.p50 = percentile(lat, 0.50);
+    r.p99 = percentile(lat, 0.99);
+    r.max = lat.back();
+    return r;
+}
+
+// Sweep benchmark: latency is the gap between consecutive delivered points
+static Result measureSweep(const std::string& name, MeasurementManager& meas, const SweepPlan& plan,
+                           void (*sweep)(MeasurementManager&, const SweepPlan&, const PointCallback&)) {
+    std::vector<double> gaps;
+    gaps.reserve(plan.points);
+    auto start = Clock::now();
+    auto last = start;
+    sweep(meas, plan, [&](const SweepPoint&) {
+        auto now = Clock::now();
+        gaps.push_back(std::chrono::duration<double, std::micro>(now - last).count());
+        last = now;
+    });
+    Result r;
+    r.name = name;
+    r.unit = "points";
+    r.ops = gaps.size();
+    r.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::sort(gaps.begin(), gaps.end());
+    r.p50 = percentile(gaps, 0.50);
+    r.p99 = percentile(gaps, 0.99);
+    r.max = gaps.empty() ? 0.0 : gaps.back();
+    return r;
+}
+
+// All cases for one network latency
+static void runScenario(const Endpoint& ep, double latencyMs, bool quick, std::vector<Result>& out) {
+    std::unique_ptr<ScpiSimulator> sim;
+    int port = ep.port;
+    if (port == 0) {
+        SimConfig config;
+        config.port = 0;
+        config.latency = latencyMs / 1000.0;
+        config.noiseRel = 1e-4;
+        sim = std::make_unique<ScpiSimulator>(config);
+        sim->start();
+        port = sim->port();
+    }
+
+    char tag[32];
+    std::snprintf(tag, sizeof(tag), "lat=%gms", latencyMs);
+    std::string suffix = std::string("/") + tag;
+
+    std::size_t n = quick ? 100 : 1000;
+    if (latencyMs >= 1.0) n /= 4;
+
+    MeasurementManager meas(Machine(ep.host, port));
+    meas.identify();
+
+    out.push_back(measure("sendCommand.query" + suffix, "commands", n, 1,
+                          [&] { meas.sendCommand(":MEAS:VOLT?"); }));
+    out.push_back(measure("sendCommand.set" + suffix, "commands", n, 1,
+                          [&] { meas.sendCommand(":SOUR:VOLT 0.5"); }));
+    out.push_back(measure("measureAverage.x10" + suffix, "commands", n / 10, 10,
+                          [&] { meas.measureAverage(":MEAS:CURR?", 10); }));
+    out.push_back(measure("getBasicMeasurement" + suffix, "points", n, 1,
+                          [&] { meas.getBasicMeasurement(); }));
+
+    // Bulk readback of growing response sizes, ASCII vs binary
+    for (int size : quick ? std::vector<int>{100, 1000} : std::vector<int>{100, 1000, 2500}) {
+        std::vector<double> volts(size);
+        for (int i = 0; i < size; ++i) volts[i] = i * 1e-3;
+        meas.listSweep(volts, 0.0);
+        for (DataFormat fmt : {DataFormat::Ascii, DataFormat::Real64}) {
+            meas.setDataFormat(fmt);
+            std::vector<double> values(size);
+            std::string name = std::string("fetch.") + (fmt == DataFormat::Ascii ? "ascii" : "real64") +
+                               ".n=" + std::to_string(size) + suffix;
+            out.push_back(measure(name, "points", quick ? 20 : 100, size,
+                                  [&] { meas.queryReals(":FETC:ARR:CURR?", values); }));
+        }
+        meas.setDataFormat(DataFormat::Ascii);
+    }
+
+    // Full resistance sweeps with no settle delay, so only the acquisition path is timed
+    for (int points : quick ? std::vector<int>{10, 100} : std::vector<int>{10, 100, 1000}) {
+        SweepPlan plan;
+        plan.vstart = 0.0;
+        plan.vend = 1.0;
+        plan.points = points;
+        plan.settle.fixedDelay = 0.0;
+        if (points <= 100 || latencyMs < 1.0)
+            out.push_back(measureSweep("sweep.manual.n=" + std::to_string(points) + suffix, meas, plan,
+                                       runManualSweep));
+        out.push_back(measureSweep("sweep.list.n=" + std::to_string(points) + suffix, meas, plan,
+                                   runListSweep));
+    }
+}
+
+// Record real sweep traffic once, then replay it through MeasurementManager and
+// DataManager, so parsing and storage run at memory speed with no network involved
+static void runReplay(const Endpoint& ep, bool quick, std::vector<Result>& out) {
+    std::unique_ptr<ScpiSimulator> sim;
+    int port = ep.port;
+    if (port == 0) {
+        SimConfig config;
+        config.port = 0;
+        config.noiseRel = 1e-4;
+        sim = std::make_unique<ScpiSimulator>(config);
+        sim->start();
+        port = sim->port();
+    }
+
+    for (bool list : {false, true}) {
+        SweepPlan plan;
+        plan.vstart = 0.0;
+        plan.vend = 1.0;
+        plan.points = list ? 1000 : 200;
+        plan.settle.fixedDelay = 0.0;
+        auto sweep = list ? runListSweep : runManualSweep;
+
+        std::string log = "/tmp/bench_replay_" + std::to_string(::getpid()) + ".bin";
+        {
+            MeasurementManager rec(Machine(ep.host, port));
+            rec.recordTraffic(true);
+            rec.identify();
+            sweep(rec, plan, [](const SweepPoint&) {});
+            rec.saveTrafficLog(log);
+        }
+
+        std::string name = std::string("replay.sweep.") + (list ? "list" : "manual") +
+                           ".n=" + std::to_string(plan.points);
+        DataManager data;
+        data.reserve(plan.points);
+        out.push_back(measure(name, "points", quick ? 20 : 200, plan.points, [&] {
+            MeasurementManager rep(Machine(ep.host, port));
+            rep.replayFrom(log);
+            const std::string& idn = rep.identify();
+            data.clear();
+            sweep(rep, plan, [&](const SweepPoint& p) {
+                data.addMeasurement(idn, p.voltage, p.current, p.settleTime, p.setVoltage);
+            });
+        }));
+        std::remove(log.c_str());
+        std::remove(CommandLogReader::indexPath(log).c_str());
+    }
+}
+
+// Results as a JSON document
+static std::string toJson(const std::vector<Result>& results) {
+    std::ostringstream js;
+    js << "{\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char line[512];
+        std::snprintf(line, sizeof(line),
+                      "    {\"name\": \"%s\", \"unit\": \"%s\", \"ops\": %zu, \"seconds\": %.6f, "
+                      "\"per_sec\": %.3f, \"p50_us\": %.2f, \"p99_us\": %.2f, \"max_us\": %.2f}%s\n",
+                      r.name.c_str(), r.unit.c_str(), r.ops, r.seconds, r.rate(), r.p50, r.p99, r.max,
+                      i + 1 < results.size() ? "," : "");
+        js << line;
+    }
+    js << "  ]\n}\n";
+    return js.str();
+}
+
+// Read per_sec and p99_us of every case from an earlier JSON output
+static std::map<std::string, std::pair<double, double>> loadBaseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot read baseline: " + path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    std::string text = ss.str();
+
+    std::map<std::string, std::pair<double, double>> base;
+    std::regex entry(R"re("name": "([^"]+)".*?"per_sec": ([0-9.eE+-]+).*?"p99_us": ([0-9.eE+-]+))re");
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), entry); it != std::sregex_iterator(); ++it)
+        base[(*it)[1]] = {std::stod((*it)[2]), std::stod((*it)[3])};
+    return base;
+}
+
+int main(int argc, char** argv) {
+    Endpoint ep;
+    bool quick = false;
+    std::string outPath, baselinePath;
+    double threshold = 0.15;
+    double minDeltaUs = 50.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opt = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << opt << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (opt == "--quick") quick = true;
+        else if (opt == "--port") ep.port = std::stoi(value());
+        else if (opt == "--host") ep.host = value();
+        else if (opt == "--out") outPath = value();
+        else if (opt == "--baseline") baselinePath = value();
+        else if (opt == "--threshold") threshold = std::stod(value());
+        else if (opt == "--min-delta-us") minDeltaUs = std::stod(value());
+        else {
+            std::cerr << "Unknown option: " << opt << "\n";
+            return 2;
+        }
+    }
+
+    // An external endpoint has whatever latency it has; simulate several otherwise
+    std::vector<double> latencies = ep.port ? std::vector<double>{0.0} : std::vector<double>{0.0, 0.5, 2.0};
+    std::vector<Result> results;
+    for (double lat : latencies) runScenario(ep, lat, quick, results);
+    runReplay(ep, quick, results);
+
+    std::string json = toJson(results);
+    if (outPath.empty()) {
+        std::cout << json;
+    } else {
+        std::ofstream(outPath) << json;
+        std::cerr << "[✓] Saved to " << outPath << std::endl;
+    }
+
+    if (baselinePath.empty()) return 0;
+
+    // Lower throughput or higher tail latency than the baseline counts as a regression
+    auto base = loadBaseline(baselinePath);
+    int regressions = 0;
+    for (const auto& r : results) {
+        auto it = base.find(r.name);
+        if (it == base.end()) continue;
+        auto [rate, p99] = it->second;
+        if (r.rate() < rate * (1.0 - threshold)) {
+            std::fprintf(stderr, "[!] %s: %.1f %s/s vs baseline %.1f\n", r.name.c_str(), r.rate(), r.unit.c_str(), rate);
+            ++regressions;
+        }
+        if (r.p99 > p99 * (1.0 + threshold) && r.p99 - p99 > minDeltaUs) {
+            std::fprintf(stderr, "[!] %s: p99 %.1f us vs baseline %.1f us\n", r.name.c_str(), r.p99, p99);
+            ++regressions;
+        }
+    }
+    std::fprintf(stderr, "%d regression(s) against %s\n", regressions, baselinePath.c_str());
+    return regressions ? 1 : 0;
+}
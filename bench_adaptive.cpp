@@ -0,0 +1,77 @@
+// Benchmark: adaptive vs uniform sampling of a diode I-V curve.
+//
+// Sweeps an in-process simulated diode (noise free) with uniform grids of
+// increasing size and with the adaptive sweep, then compares the linear
+// interpolation of each measured curve against the exact model on a dense
+// grid. Reports instrument measurements and the worst error relative to the
+// current span, so equal-fidelity point counts can be read off directly.
+//
+// Usage: ./bench_adaptive [vend] [tolerance]
+#include "measurement_manager.hpp"
+#include "scpi_simulator.hpp"
+#include "sweep.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Worst |interpolated - exact| over a dense grid, relative to the curve's span
+static double maxError(const std::vector<SweepPoint>& points, const SimConfig& config, double vstart, double vend) {
+    auto exact = [&](double v) {
+        double x = std::min(v / (config.ideality * 0.025852), 200.0);
+        return std::clamp(config.saturationCurrent * std::expm1(x), -config.compliance, config.compliance);
+    };
+    double lo = exact(vstart), hi = exact(vend), worst = 0.0;
+    std::size_t k = 0;
+    for (int i = 0; i <= 20000; ++i) {
+        double v = vstart + (vend - vstart) * i / 20000.0;
+        while (k + 2 < points.size() && points[k + 1].setVoltage < v) ++k;
+        const SweepPoint& a = points[k];
+        const SweepPoint& b = points[k + 1];
+        double t = (v - a.setVoltage) / (b.setVoltage - a.setVoltage);
+        worst = std::max(worst, std::fabs(a.current + t * (b.current - a.current) - exact(v)));
+    }
+    return worst / (hi - lo);
+}
+
+int main(int argc, char** argv) {
+    double vend = argc > 1 ? std::atof(argv[1]) : 0.8;
+    double tolerance = argc > 2 ? std::atof(argv[2]) : 2e-3;
+
+    SimConfig config;
+    config.port = 0;
+    config.model = SimModel::Diode;
+    ScpiSimulator sim(config);
+    sim.start();
+    Machine machine("127.0.0.1", sim.port());
+    MeasurementManager meas(machine);
+
+    SweepPlan plan;
+    plan.vstart = 0.0;
+    plan.vend = vend;
+    plan.settle.mode = SettleMode::Fixed;
+    plan.settle.fixedDelay = 0.0;
+
+    auto run = [&](const SweepPlan& p) {
+        std::vector<SweepPoint> points;
+        runManualSweep(meas, p, [&](const SweepPoint& pt) { points.push_back(pt); });
+        return points;
+    };
+
+    std::printf("diode 0..%.2f V, error = max |interpolated - exact| / current span\n", vend);
+    for (int n : {25, 50, 100, 200, 400, 800, 1600}) {
+        plan.points = n;
+        std::printf("%-10s %5d points  error %.2e\n", "uniform", n, maxError(run(plan), config, plan.vstart, vend));
+    }
+
+    plan.adaptive = true;
+    plan.tolerance = tolerance;
+    plan.points = 1600;
+    std::vector<SweepPoint> points;
+    runAdaptiveSweep(meas, plan, [&](const SweepPoint& pt) { points.push_back(pt); });
+    std::printf("%-10s %5zu points  error %.2e  (tolerance %.1e, budget %d)\n", "adaptive", points.size(),
+                maxError(points, config, plan.vstart, vend), tolerance, plan.points);
+    sim.stop();
+    return 0;
+}
@@ -0,0 +1,151 @@
+// Benchmark: I-V analysis kernels and batch characterization of run files.
+//
+// Kernels run over one long synthetic sweep, each next to the per-point code
+// it replaces (DataManager::resistance per sample, Welford RunningStats,
+// single-accumulator least-squares sums). Then a directory of run files is
+// characterized with analyzeRunFiles on one thread and on all cores, and a
+// sample of them through a CSV round trip (parse the CSV, then analyze) as
+// the offline scripts did. Reports ns/point and runs/s.
+//
+// Usage: ./bench_analysis [points] [runs] [run_points] [dir]
+#include "analysis.hpp"
+#include "statistics.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Time fn over enough repetitions for a stable figure; returns ns per point
+template <typename Fn>
+static double nsPerPoint(std::size_t n, Fn fn) {
+    int reps = 0;
+    auto t0 = Clock::now();
+    do {
+        fn();
+        ++reps;
+    } while (since(t0) < 0.3);
+    return since(t0) / reps / n * 1e9;
+}
+
+static void row(const char* name, double ns, double baseline = 0.0) {
+    if (baseline > 0) std::printf("%-28s %8.3f ns/point   %5.1fx\n", name, ns, baseline / ns);
+    else std::printf("%-28s %8.3f ns/point\n", name, ns);
+}
+
+// 1 kOhm resistor with noise and a spike every 997 points
+static void makeSweep(std::size_t n, std::vector<double>& v, std::vector<double>& i, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> noise(0.0, 1e-7);
+    v.resize(n);
+    i.resize(n);
+    for (std::size_t k = 0; k < n; ++k) {
+        v[k] = -1.0 + 2.0 * k / (n - 1);
+        i[k] = v[k] / 1000.0 + noise(rng) + (k % 997 == 500 ? 1e-4 : 0.0);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::size_t runs = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    std::size_t runPoints = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000;
+    std::string dir = (argc > 4 ? std::filesystem::path(argv[4]) : std::filesystem::temp_directory_path() /
+                                                                      "bench_analysis").string();
+
+    std::vector<double> v, i, out(n);
+    makeSweep(n, v, i, 1);
+    volatile double sink = 0.0;
+    std::printf("Kernels over %zu points\n", n);
+
+    double base = nsPerPoint(n, [&] {
+        for (std::size_t k = 0; k < n; ++k) out[k] = DataManager::resistance(v[k], i[k]);
+    });
+    row("R per point (scalar)", base);
+    row("resistances", nsPerPoint(n, [&] { resistances(v, i, out); }), base);
+
+    base = nsPerPoint(n, [&] {
+        RunningStats s;
+        for (double x : i) s.add(x);
+        sink = sink + s.stddev();
+    });
+    row("RunningStats (Welford)", base);
+    row("columnStats", nsPerPoint(n, [&] { sink = sink + columnStats(i).stddev; }), base);
+
+    base = nsPerPoint(n, [&] {
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        for (std::size_t k = 0; k < n; ++k) {
+            sx += v[k];
+            sy += i[k];
+            sxx += v[k] * v[k];
+            sxy += v[k] * i[k];
+        }
+        sink = sink + (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    });
+    row("fit sums (one accumulator)", base);
+    LineFit fit;
+    row("fitLine", nsPerPoint(n, [&] { fit = fitLine(v, i); }), base);
+    row("fitLine, |V| <= 0.5", nsPerPoint(n, [&] { sink = sink + fitLine(v, i, -0.5, 0.5).slope; }));
+    row("derivative", nsPerPoint(n, [&] { derivative(v, i, out); }));
+    row("differentialResistance", nsPerPoint(n, [&] { differentialResistance(v, i, out); }));
+    row("movingAverage (7)", nsPerPoint(n, [&] { movingAverage(i, out, 7); }));
+    row("movingMedian (7)", nsPerPoint(n, [&] { movingMedian(i, out, 7); }));
+    std::vector<std::uint8_t> flags(n);
+    std::size_t outliers = 0;
+    row("flagOutliers (21)", nsPerPoint(n, [&] { outliers = flagOutliers(i, flags); }));
+    std::printf("fit R %.3f Ohm (1000 expected), r2 %.6f, %zu outliers (%zu spikes)\n", 1.0 / fit.slope, fit.r2,
+                outliers, (n + 496) / 997);
+
+    // Batch characterization of stored runs
+    std::filesystem::create_directories(dir);
+    std::vector<std::string> paths;
+    for (std::size_t r = 0; r < runs; ++r) {
+        DataManager data;
+        makeSweep(runPoints, v, i, static_cast<unsigned>(r + 2));
+        for (std::size_t k = 0; k < runPoints; ++k)
+            data.addMeasurement("Keysight Technologies,B2901A,MY12345678,3.4.2011.5100", v[k], i[k]);
+        paths.push_back(dir + "/run_" + std::to_string(r) + ".run");
+        writeRunFile(paths.back(), data);
+    }
+    std::printf("\n%zu run files of %zu points\n", runs, runPoints);
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads : {1u, cores}) {
+        auto t0 = Clock::now();
+        std::vector<IvSummary> results = analyzeRunFiles(paths, threads);
+        double sec = since(t0);
+        std::size_t ok = std::count_if(results.begin(), results.end(), [](const IvSummary& s) { return s.ok; });
+        std::printf("run files, %2u thread(s)      %8.3f s  %9.0f runs/s  (%zu ok)\n", threads, sec, runs / sec, ok);
+        if (threads == cores) break;
+    }
+
+    // The old route: every run exported to CSV and parsed again before analysis
+    std::size_t sample = std::min<std::size_t>(runs, 100);
+    std::vector<std::string> csvs;
+    for (std::size_t r = 0; r < sample; ++r) {
+        csvs.push_back(dir + "/run_" + std::to_string(r) + ".csv");
+        runFileToCsv(paths[r], csvs.back());
+    }
+    auto t0 = Clock::now();
+    std::string parsed = dir + "/parsed.run";
+    for (const auto& csv : csvs) {
+        csvToRunFile(csv, parsed);
+        RunFileReader run(parsed);
+        sink = sink + analyzeIv(run.f64("voltage"), run.f64("current")).fit.slope;
+    }
+    double sec = since(t0);
+    std::printf("CSV round trip, 1 thread      %8.3f s  %9.0f runs/s  (%zu runs)\n", sec, sample / sec, sample);
+
+    std::filesystem::remove_all(dir);
+    return 0;
+}
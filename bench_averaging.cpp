@@ -0,0 +1,83 @@
+// Benchmark: fixed-count averaging vs early stopping per point.
+//
+// A simulated 1 kOhm resistor with an absolute current noise floor is swept
+// from -1 to 1 V, so points near 0 V are relatively noisy and points near the
+// ends are quiet. Every point is averaged three ways:
+//   - fixed: always maxSamples readings (measureAverage)
+//   - early stop: stop once the 95 % CI of the mean is below the target
+//   - early stop + instrument: the remaining readings averaged on the instrument
+// Reports host readings, wall time and how many points actually landed within
+// the target of the true current.
+//
+// Usage: ./bench_averaging [points] [max_readings] [target_rel] [latency_ms]
+#include "measurement_manager.hpp"
+#include "scpi_simulator.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    int points = argc > 1 ? std::atoi(argv[1]) : 100;
+    int maxReadings = argc > 2 ? std::atoi(argv[2]) : 64;
+    double target = argc > 3 ? std::atof(argv[3]) : 1e-3;
+    double latencyMs = argc > 4 ? std::atof(argv[4]) : 0.2;
+
+    SimConfig config;
+    config.port = 0;
+    config.resistance = 1000.0;
+    config.noiseRel = 2e-4;
+    config.noiseAbs = 2e-7;
+    config.latency = latencyMs / 1000.0;
+    config.aperture = 20e-6;
+    ScpiSimulator sim(config);
+    sim.start();
+    Machine machine("127.0.0.1", sim.port());
+    MeasurementManager meas(machine);
+
+    std::vector<double> volts;
+    for (int i = 0; i < points; ++i) volts.push_back(-1.0 + 2.0 * (i + 0.5) / points);  // Never exactly 0 V
+
+    auto run = [&](const char* name, const AverageOptions* options) {
+        long hostReadings = 0, instrumentReadings = 0;
+        int within = 0;
+        auto t0 = Clock::now();
+        for (double v : volts) {
+            meas.sendBatch({":SOUR:VOLT " + formatReal(v), ":OUTP ON"});
+            double mean;
+            if (options) {
+                AverageResult r = meas.measureStatistics(":MEAS:CURR?", *options);
+                mean = r.mean;
+                hostReadings += r.samples + r.rejected;
+                instrumentReadings += r.instrumentSamples;
+            } else {
+                mean = meas.measureAverage(":MEAS:CURR?", maxReadings);
+                hostReadings += maxReadings;
+            }
+            double truth = v / config.resistance;
+            if (std::fabs(mean - truth) <= target * std::fabs(truth)) ++within;
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::printf("%-24s %7ld host + %7ld instrument readings  %7.3f s  %3d/%d points within %.1e\n", name,
+                    hostReadings, instrumentReadings, sec, within, points, target);
+    };
+
+    AverageOptions early;
+    early.minSamples = 4;
+    early.maxSamples = maxReadings;
+    early.targetRelative = target;
+    AverageOptions offload = early;
+    offload.instrumentAveraging = true;
+
+    std::printf("%d points, up to %d readings each, target %.1e relative (95 %% CI), %.2f ms latency\n", points,
+                maxReadings, target, latencyMs);
+    run("fixed", nullptr);
+    run("early stop", &early);
+    run("early stop + instrument", &offload);
+    sim.stop();
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Benchmark: CSV export rows/s, iostream vs streaming writer.
+//
+// Fills a DataManager with synthetic samples and writes them three ways:
+//   - the previous export path (std::ofstream <<, timestamp formatted per row)
+//   - CsvStreamWriter with the default policy (1 s flushes, background fdatasync)
+//   - CsvStreamWriter flushing every 100 rows (tight crash window)
+// Also reports the worst single appendRow stall seen by the measurement loop.
+//
+// Usage: ./bench_csv [rows] [dir]
+#include "csv_writer.hpp"
+#include "data_manager.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Time one streaming configuration, tracking the slowest append
+static void runStream(const char* name, const DataManager& data, const std::string& path,
+                      const CsvFlushPolicy& policy, FsyncPolicy sync) {
+    std::filesystem::remove(path);
+    double worst = 0.0;
+    auto t0 = Clock::now();
+    {
+        CsvStreamWriter out(path, policy, sync);
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            auto a = Clock::now();
+            out.appendRow(data, i);
+            worst = std::max(worst, since(a));
+        }
+        out.close();
+    }
+    double sec = since(t0);
+    std::printf("%-32s %12.0f rows/s  %8.3f s  worst append %.3f ms\n", name, data.size() / sec, sec, worst * 1e3);
+}
+
+int main(int argc, char** argv) {
+    std::size_t rows = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::string dir = argc > 2 ? argv[2] : std::filesystem::temp_directory_path().string();
+
+    DataManager data;
+    data.reserve(rows);
+    for (std::size_t i = 0; i < rows; ++i) {
+        double v = -1.0 + 2.0 * i / rows;
+        data.addMeasurement("Keysight Technologies,B2901A,MY12345678,3.4.2011.5100", v, v / 1234.5678, 0.2, v);
+    }
+
+    // Previous export: iostream with default precision and a per-row timestamp
+    std::string legacyPath = dir + "/bench_legacy.csv";
+    auto t0 = Clock::now();
+    {
+        std::ofstream out(legacyPath);
+        out << CsvStreamWriter::header();
+        for (std::size_t i = 0; i < data.size(); ++i) {
+            MeasurementData m = data.row(i);
+            out << m.timestamp << "," << m.vendor << "," << m.model << "," << m.serial << "," << m.firmware
+                << "," << m.voltage << "," << m.current << "," << m.resistance << "," << m.settleTime
+                << "," << m.setVoltage << "\n";
+        }
+    }
+    double sec = since(t0);
+    std::printf("%-32s %12.0f rows/s  %8.3f s\n", "iostream (previous saveCSV)", rows / sec, sec);
+
+    runStream("stream, 1 s flush + async sync", data, dir + "/bench_stream.csv", CsvFlushPolicy{}, FsyncPolicy::OnFlush);
+
+    CsvFlushPolicy tight;
+    tight.everyRows = 100;
+    runStream("stream, flush every 100 rows", data, dir + "/bench_stream_tight.csv", tight, FsyncPolicy::OnFlush);
+
+    std::filesystem::remove(legacyPath);
+    std::filesystem::remove(dir + "/bench_stream.csv");
+    std::filesystem::remove(dir + "/bench_stream_tight.csv");
+    return 0;
+}
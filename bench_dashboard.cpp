@@ -0,0 +1,79 @@
+// Benchmark: cost of the live run dashboard.
+//
+// A producer paced like an instrument (one point every period) hands points
+// to the dashboard the way main() does, while the UI thread draws into a
+// scratch file standing in for the terminal:
+//   - incremental: only rows that changed since the last frame are rewritten
+//   - full redraw: clear() and repaint every frame (what a naive loop does)
+// Reports the acquisition thread's time per point (mean and worst), frames,
+// rows rewritten and bytes sent to the terminal per frame, and UI thread time.
+//
+// Usage: ./bench_dashboard [points] [period_us] [frame_ms]
+#include "dashboard.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static void run(const char* name, std::size_t n, std::chrono::nanoseconds period, double frameMs, bool full) {
+    FILE* term = std::tmpfile();
+    DashboardConfig config;
+    config.title = "Resistance sweep -1 V -> 1 V (benchmark)";
+    config.total = n;
+    config.frameSeconds = frameMs / 1000.0;
+    config.fullRedraw = full;
+    config.terminal = term;
+    RunDashboard dashboard(config);
+    dashboard.start();
+
+    ScpiLinkStats link;
+    double busy = 0.0, worst = 0.0;
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        auto due = t0 + i * period;
+        while (Clock::now() < due) {}
+        auto a = Clock::now();
+        double v = -1.0 + 2.0 * i / n;
+        double current = 1e-12 * std::expm1(v / 0.02585);
+        dashboard.push({v, current, v / current, 0.0, Profiler::nowNs()});
+        if (i % 1000 == 999) ++link.retries;
+        dashboard.setLinkStats(link);
+        double dt = since(a);
+        busy += dt;
+        worst = std::max(worst, dt);
+    }
+    dashboard.stop();
+
+    std::fflush(term);
+    long bytes = std::ftell(term);
+    std::fclose(term);
+    DashboardStats s = dashboard.stats();
+    std::printf("%-12s push mean %6.3f us  worst %7.3f us | %4llu frames  %5.1f rows/frame  %7.0f bytes/frame  "
+                "%6.3f ms/frame  dropped %llu\n",
+                name, busy / n * 1e6, worst * 1e6, static_cast<unsigned long long>(s.frames),
+                static_cast<double>(s.rowsDrawn) / std::max<std::uint64_t>(s.frames, 1),
+                static_cast<double>(bytes) / std::max<std::uint64_t>(s.frames, 1),
+                s.renderSeconds / std::max<std::uint64_t>(s.frames, 1) * 1e3,
+                static_cast<unsigned long long>(s.dropped));
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+    std::chrono::nanoseconds period(static_cast<long long>((argc > 2 ? std::atof(argv[2]) : 100.0) * 1000));
+    double frameMs = argc > 3 ? std::atof(argv[3]) : 100.0;
+
+    // The scratch terminal needs a terminal description; any common one will do
+    setenv("TERM", "xterm", 0);
+    std::printf("%zu points every %.1f us, frame every %.0f ms, 80x24 terminal\n", n, period.count() / 1e3, frameMs);
+    run("incremental", n, period, frameMs, false);
+    run("full redraw", n, period, frameMs, true);
+    return 0;
+}
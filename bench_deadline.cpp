@@ -0,0 +1,95 @@
+// Benchmark: query latency on a link with occasional slow replies.
+//
+// A simulated instrument answers every query after a short latency, but a
+// small fraction of replies is held back for much longer (a busy lab network
+// or instrument). The same queries run twice:
+//   - no deadline: wait for every reply however long it takes
+//   - deadline: give up on a reply after the timeout, reconnect and ask again
+// Reports p50/p99/max latency per query and the session's fault counters.
+// Finally a query the instrument never answers shows the deadline turning a
+// hang into a classified timeout error.
+//
+// Usage: ./bench_deadline [queries] [slow_prob] [slow_ms] [timeout_ms] [latency_ms]
+#include "measurement_manager.hpp"
+#include "scpi_simulator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    std::size_t idx = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+    int queries = argc > 1 ? std::atoi(argv[1]) : 400;
+    double slowProb = argc > 2 ? std::atof(argv[2]) : 0.02;
+    double slowMs = argc > 3 ? std::atof(argv[3]) : 300.0;
+    double timeoutMs = argc > 4 ? std::atof(argv[4]) : 20.0;
+    double latencyMs = argc > 5 ? std::atof(argv[5]) : 1.0;
+
+    SimConfig config;
+    config.port = 0;
+    config.latency = latencyMs / 1000.0;
+    config.slowProbability = slowProb;
+    config.slowDelay = slowMs / 1000.0;
+    ScpiSimulator sim(config);
+    sim.start();
+
+    auto run = [&](const char* name, const ScpiPolicy& policy) {
+        MeasurementManager meas(Machine("127.0.0.1", sim.port()));
+        meas.setLinkPolicy(policy);
+        meas.sendCommand(":SOUR:VOLT 1");
+        std::vector<double> us;
+        int failed = 0;
+        auto t0 = Clock::now();
+        for (int i = 0; i < queries; ++i) {
+            auto q0 = Clock::now();
+            try {
+                meas.sendCommand(":MEAS:CURR?");
+            } catch (const ScpiError&) {
+                ++failed;
+            }
+            us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - q0).count());
+        }
+        double sec = std::chrono::duration<double>(Clock::now() - t0).count();
+        std::sort(us.begin(), us.end());
+        const ScpiLinkStats& s = meas.linkStats();
+        std::printf("%-12s %7.3f s  p50 %8.0f us  p99 %8.0f us  max %8.0f us  timeouts %zu  retries %zu  "
+                    "failed %d\n",
+                    name, sec, percentile(us, 0.5), percentile(us, 0.99), us.back(), s.timeouts, s.retries, failed);
+    };
+
+    std::printf("%d queries, %.2f ms latency, %.1f %% of replies delayed by %.0f ms, timeout %.0f ms\n", queries,
+                latencyMs, slowProb * 100, slowMs, timeoutMs);
+
+    ScpiPolicy patient;
+    patient.replyTimeout = 60.0;
+    patient.retries = 0;
+    run("no deadline", patient);
+
+    ScpiPolicy bounded;
+    bounded.replyTimeout = timeoutMs / 1000.0;
+    bounded.retries = 3;
+    bounded.backoff = 0.001;
+    run("deadline", bounded);
+
+    // Unknown headers get no reply at all; without a deadline this waits forever
+    MeasurementManager meas(Machine("127.0.0.1", sim.port()));
+    meas.setLinkPolicy(bounded);
+    auto t0 = Clock::now();
+    try {
+        meas.sendCommand(":BOGUS:QUERY?");
+    } catch (const ScpiError& e) {
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        std::printf("lost reply   %s after %.0f ms (%s)\n", faultName(e.fault()), ms, e.what());
+    }
+    sim.stop();
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Benchmark: plot decimation of long point streams.
+//
+// Streams a synthetic signal (slow sine, noise and rare spikes) through
+// MinMaxDecimator and reports ns/point, snapshot size and time, and whether
+// the global extrema and every spike survive. LTTB over the same stored
+// series is timed for comparison.
+//
+// Usage: ./bench_decimate [points] [buckets]
+#include "plot_decimator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+int main(int argc, char** argv) {
+    std::size_t points = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+    std::size_t buckets = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+
+    std::vector<double> x(points), y(points);
+    std::vector<std::size_t> spikes;
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> noise(0.0, 0.01);
+    for (std::size_t i = 0; i < points; ++i) {
+        x[i] = static_cast<double>(i);
+        y[i] = std::sin(i * 1e-5) + noise(rng);
+        if (rng() % 1000000 == 0) {
+            y[i] += (rng() & 1) ? 5.0 : -5.0;
+            spikes.push_back(i);
+        }
+    }
+
+    // Streaming min/max pyramid
+    MinMaxDecimator dec(buckets);
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < points; ++i) dec.add(x[i], y[i]);
+    double addSec = since(t0);
+
+    std::vector<PlotPoint> snap;
+    snap.reserve(8 * buckets);
+    t0 = Clock::now();
+    dec.snapshot(snap);
+    double snapSec = since(t0);
+
+    auto [lo, hi] = std::minmax_element(y.begin(), y.end());
+    bool extrema = std::any_of(snap.begin(), snap.end(), [&](const PlotPoint& p) { return p.y == *lo; }) &&
+                   std::any_of(snap.begin(), snap.end(), [&](const PlotPoint& p) { return p.y == *hi; });
+    std::size_t keptSpikes = 0;
+    for (std::size_t s : spikes)
+        keptSpikes += std::any_of(snap.begin(), snap.end(), [&](const PlotPoint& p) { return p.x == x[s]; });
+
+    std::printf("min/max pyramid  %10zu points  %6.2f ns/point  snapshot %zu points in %.1f us  "
+                "bucket %llu  extrema %s  spikes %zu/%zu\n",
+                points, addSec * 1e9 / points, snap.size(), snapSec * 1e6,
+                static_cast<unsigned long long>(dec.bucketSize()), extrema ? "kept" : "LOST", keptSpikes,
+                spikes.size());
+
+    // LTTB over the stored series, same output size
+    t0 = Clock::now();
+    auto picked = lttb(x, y, snap.size());
+    double lttbSec = since(t0);
+    keptSpikes = 0;
+    for (std::size_t s : spikes) keptSpikes += std::binary_search(picked.begin(), picked.end(), s);
+    std::printf("lttb             %10zu points  %6.2f ns/point  output %zu points  spikes %zu/%zu\n",
+                points, lttbSec * 1e9 / points, picked.size(), keptSpikes, spikes.size());
+    return extrema ? 0 : 1;
+}
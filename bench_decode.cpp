@@ -0,0 +1,99 @@
+// Benchmark: decoding bulk readbacks as ASCII text vs IEEE 488.2 REAL,64 blocks.
+//
+// Builds the same set of readings in both wire formats and times:
+//   - the legacy path (split into std::string, std::stod per value)
+//   - parseAsciiReals (from_chars, no intermediate strings)
+//   - decodeRealBlock in host byte order and in swapped byte order
+//
+// Usage: ./bench_decode [values] [rounds]
+#include "scpi_block.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Time fn over several rounds and print throughput
+template <typename Fn>
+static void run(const char* name, std::size_t values, std::size_t bytes, int rounds, Fn fn) {
+    double checksum = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) checksum += fn();
+    auto t1 = std::chrono::steady_clock::now();
+    double sec = std::chrono::duration<double>(t1 - t0).count() / rounds;
+    std::printf("%-26s %10.2f Mvalues/s %10.1f MB/s  (%.3f ms/round, checksum %.6g)\n",
+                name, values / sec / 1e6, bytes / sec / 1e6, sec * 1e3, checksum);
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+
+    // Readings that look like source-meter currents
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> dist(1e-3, 1e-4);
+    std::vector<double> readings(n);
+    for (auto& v : readings) v = dist(rng);
+
+    // ASCII reply as the instrument sends it: +1.234567890123456E-03,...
+    std::string ascii;
+    ascii.reserve(n * 24);
+    char buf[64];
+    for (std::size_t i = 0; i < n; ++i) {
+        int len = std::snprintf(buf, sizeof(buf), "%+.15E", readings[i]);
+        if (i) ascii += ',';
+        ascii.append(buf, len);
+    }
+
+    // Binary replies: '#<n><len>' header followed by the raw doubles
+    auto makeBlock = [&](bool swap) {
+        std::string payload(reinterpret_cast<const char*>(readings.data()), n * sizeof(double));
+        if (swap) swapReal64(reinterpret_cast<double*>(payload.data()), n);
+        std::string len = std::to_string(payload.size());
+        return "#" + std::to_string(len.size()) + len + payload;
+    };
+    ByteOrder native = nativeByteOrder();
+    ByteOrder foreign = native == ByteOrder::Swapped ? ByteOrder::Normal : ByteOrder::Swapped;
+    std::string blockNative = makeBlock(false);
+    std::string blockForeign = makeBlock(true);
+
+    std::vector<double> out(n);
+    std::printf("%zu values, ASCII %zu bytes, binary %zu bytes, %d rounds\n",
+                n, ascii.size(), blockNative.size(), rounds);
+
+    run("ascii: string + stod", n, ascii.size(), rounds, [&] {
+        std::vector<double> values;
+        std::size_t start = 0;
+        while (start < ascii.size()) {
+            std::size_t comma = ascii.find(',', start);
+            if (comma == std::string::npos) comma = ascii.size();
+            values.push_back(std::stod(ascii.substr(start, comma - start)));
+            start = comma + 1;
+        }
+        return values.back();
+    });
+
+    run("ascii: from_chars", n, ascii.size(), rounds, [&] {
+        std::size_t got = parseAsciiReals(ascii, out);
+        return out[got - 1];
+    });
+
+    run("binary: native order", n, blockNative.size(), rounds, [&] {
+        std::size_t got = decodeRealBlock(blockNative, native, out);
+        return out[got - 1];
+    });
+
+    run("binary: swapped order", n, blockForeign.size(), rounds, [&] {
+        std::size_t got = decodeRealBlock(blockForeign, foreign, out);
+        return out[got - 1];
+    });
+
+    // Binary is exact; ASCII with 16 significant digits may round the last bit
+    std::size_t mismatches = 0;
+    parseAsciiReals(ascii, out);
+    for (std::size_t i = 0; i < n; ++i) mismatches += out[i] != readings[i];
+    std::printf("ascii round-trip mismatches: %zu of %zu\n", mismatches, n);
+    return 0;
+}
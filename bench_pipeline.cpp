@@ -0,0 +1,125 @@
+// Benchmark: acquisition-side cost of handing points to consumer stages.
+//
+// A producer paced like an instrument (one point every period) stamps and
+// hands over synthetic sweep points the way main() does:
+//   - inline: store and export run on the acquisition thread (previous loop)
+//   - pipeline: store, export and plot stages each on their own SPSC queue
+//   - slow plot: the plot stage sleeps per point and drops on overflow
+// Reports the mean and worst time the acquisition thread spends per point
+// (what it is not measuring) and per-stage queue stats.
+//
+// Usage: ./bench_pipeline [points] [period_us] [dir]
+#include "csv_writer.hpp"
+#include "data_manager.hpp"
+#include "pipeline.hpp"
+#include "sweep.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static const std::string kIdn = "Keysight Technologies,B2901A,MY12345678,3.4.2011.5100";
+
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+static SweepPoint makePoint(std::size_t i, std::size_t n) {
+    double v = -1.0 + 2.0 * i / n;
+    return {static_cast<int>(i), v, v, v / 1234.5678, 0.0};
+}
+
+static void report(const char* name, std::size_t n, double busy, double worst) {
+    std::printf("%-24s mean %8.3f us/point  worst %8.3f us\n", name, busy / n * 1e6, worst * 1e6);
+}
+
+// Spin until the next acquisition slot, like waiting on the instrument
+static void waitSlot(Clock::time_point t0, std::size_t i, std::chrono::nanoseconds period) {
+    auto due = t0 + i * period;
+    while (Clock::now() < due) {}
+}
+
+// Run one pipeline configuration; plotDelay > 0 makes the plot stage lag behind
+static void runPipeline(const char* name, std::size_t n, std::chrono::nanoseconds period,
+                        const std::string& csvPath, std::chrono::microseconds plotDelay) {
+    std::filesystem::remove(csvPath);
+    DataManager data;
+    data.reserve(n);
+    CsvStreamWriter csv(csvPath, {}, FsyncPolicy::Never);
+    InstrumentInfo inst = DataManager::parseIdn(kIdn);
+    volatile double plotted = 0.0;
+
+    Pipeline<AcquiredPoint> pipeline;
+    pipeline.addStage("store", [&](const AcquiredPoint& a) {
+        data.addMeasurement(kIdn, a.monotonicNs, a.wallNs, a.point.voltage, a.point.current, a.point.settleTime,
+                            a.point.setVoltage);
+    });
+    pipeline.addStage("export", [&](const AcquiredPoint& a) {
+        csv.appendRow(a.wallNs, inst, a.point.voltage, a.point.current,
+                      DataManager::resistance(a.point.voltage, a.point.current), a.point.settleTime,
+                      a.point.setVoltage);
+    });
+    pipeline.addStage("plot", [&](const AcquiredPoint& a) {
+        if (plotDelay.count() > 0) std::this_thread::sleep_for(plotDelay);
+        plotted = plotted + a.point.current;
+    }, 4096, StagePolicy::Drop);
+    pipeline.start();
+
+    double busy = 0.0, worst = 0.0;
+    auto t0 = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        waitSlot(t0, i, period);
+        auto a = Clock::now();
+        pipeline.push(AcquiredPoint::stamp(makePoint(i, n)));
+        double dt = since(a);
+        busy += dt;
+        worst = std::max(worst, dt);
+    }
+    pipeline.finish();
+    csv.close();
+
+    report(name, n, busy, worst);
+    writeStageStats(std::cout, pipeline.stats());
+    if (data.size() != n || csv.rows() != n) std::printf("  LOST POINTS: stored %zu, exported %zu\n", data.size(), csv.rows());
+    std::filesystem::remove(csvPath);
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    std::chrono::nanoseconds period(static_cast<long long>((argc > 2 ? std::atof(argv[2]) : 10.0) * 1000));
+    std::string dir = argc > 3 ? argv[3] : std::filesystem::temp_directory_path().string();
+    std::string csvPath = dir + "/bench_pipeline.csv";
+
+    // Previous loop: store and export on the acquisition thread
+    {
+        std::filesystem::remove(csvPath);
+        DataManager data;
+        data.reserve(n);
+        CsvStreamWriter csv(csvPath, {}, FsyncPolicy::Never);
+        double busy = 0.0, worst = 0.0;
+        auto t0 = Clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            waitSlot(t0, i, period);
+            auto a = Clock::now();
+            SweepPoint p = makePoint(i, n);
+            data.addMeasurement(kIdn, p.voltage, p.current, p.settleTime, p.setVoltage);
+            csv.appendRow(data, data.size() - 1);
+            double dt = since(a);
+            busy += dt;
+            worst = std::max(worst, dt);
+        }
+        csv.close();
+        report("inline", n, busy, worst);
+        std::filesystem::remove(csvPath);
+    }
+
+    runPipeline("pipeline", n, period, csvPath, std::chrono::microseconds(0));
+    runPipeline("pipeline, slow plot", n, period, csvPath, std::chrono::microseconds(100));
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include "checksum.hpp"
+#include <algorithm>
+#include <vector>
+
+std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc) {
+    static const auto table = [] {
+        std::vector<std::uint32_t> t(256);
+        for (std::uint32_t n = 0; n < 256; ++n) {
+            std::uint32_t c = n;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+std::uint32_t adler32(const std::uint8_t* data, std::size_t size) {
+    std::uint32_t a = 1, b = 0;
+    while (size > 0) {
+        std::size_t n = std::min<std::size_t>(size, 5552);  // Largest run without 32-bit overflow
+        size -= n;
+        for (; n > 0; --n) {
+            a += *data++;
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+    }
+    return (b << 16) | a;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Checksums shared by the PNG/zlib containers and the sweep journal
+
+// CRC-32 (IEEE 802.3, as in PNG and zlib); pass a previous result to continue it
+std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0);
+
+// Adler-32 of a zlib stream
+std::uint32_t adler32(const std::uint8_t* data, std::size_t size);
@@ -0,0 +1,173 @@
+#include "command_log.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kIndexMagic[8] = {'C', 'D', 'A', 'I', 'D', 'X', '1', '\0'};
+
+// Sidecar index header, followed by count uint64 record offsets
+struct IndexHeader {
+    char magic[8];
+    std::uint64_t logSize;     // Log size the index was built for
+    std::int64_t logMtimeNs;   // And its modification time
+    std::uint64_t count;
+};
+
+} // namespace
+
+// Same layout saveToBinaryFile has always produced
+void writeCommandLog(const std::string& path, const std::vector<CommandRecord>& records) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+    for (const auto& [cmd, res] : records) {
+        uint32_t cmd_len = cmd.size();
+        uint32_t res_len = res.size();
+        out.write(reinterpret_cast<const char*>(&cmd_len), sizeof(cmd_len));
+        out.write(cmd.c_str(), cmd_len);
+        out.write(reinterpret_cast<const char*>(&res_len), sizeof(res_len));
+        out.write(res.c_str(), res_len);
+    }
+    if (!out) throw std::runtime_error("Failed to write " + path);
+}
+
+// Map the log read-only, then load or rebuild the record index
+CommandLogReader::CommandLogReader(const std::string& path, bool useIndex)
+    : map_(nullptr), size_(0), mtimeNs_(0), indexLoaded_(false) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot open command log: " + path);
+    struct stat st{};
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Cannot stat command log: " + path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    mtimeNs_ = static_cast<std::int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    // An empty log cannot be mapped, but is a valid log with no records
+    if (size_ > 0) {
+        void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("mmap failed: " + path);
+        }
+        map_ = static_cast<const char*>(map);
+        madvise(map, size_, MADV_RANDOM);
+    }
+    ::close(fd);
+
+    if (useIndex && loadIndex(indexPath(path))) {
+        indexLoaded_ = true;
+        return;
+    }
+    scan();
+    if (useIndex) saveIndex(indexPath(path));
+}
+
+CommandLogReader::~CommandLogReader() {
+    if (map_) munmap(const_cast<char*>(map_), size_);
+}
+
+std::string CommandLogReader::indexPath(const std::string& logPath) {
+    return logPath + ".idx";
+}
+
+std::size_t CommandLogReader::size() const {
+    return offsets_.size();
+}
+
+bool CommandLogReader::indexLoaded() const {
+    return indexLoaded_;
+}
+
+// End of the record starting at offset, or 0 if it runs past the end of the file
+std::uint64_t CommandLogReader::recordEnd(std::uint64_t offset) const {
+    std::uint64_t p = offset;
+    for (int f = 0; f < 2; ++f) {
+        std::uint32_t len = 0;
+        if (p + sizeof(len) > size_) return 0;
+        std::memcpy(&len, map_ + p, sizeof(len));
+        p += sizeof(len) + len;
+        if (p > size_) return 0;
+    }
+    return p;
+}
+
+// Walk the records; stop at the first incomplete one
+void CommandLogReader::scan() {
+    offsets_.clear();
+    std::uint64_t pos = 0;
+    while (std::uint64_t end = recordEnd(pos)) {
+        offsets_.push_back(pos);
+        pos = end;
+    }
+}
+
+// Accept the sidecar only if it was built for exactly this version of the log
+bool CommandLogReader::loadIndex(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    IndexHeader h{};
+    if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) return false;
+    if (std::memcmp(h.magic, kIndexMagic, sizeof(kIndexMagic)) != 0 || h.logSize != size_ ||
+        h.logMtimeNs != mtimeNs_ || h.count > size_ / (2 * sizeof(std::uint32_t)))
+        return false;
+    offsets_.resize(h.count);
+    bool ok = static_cast<bool>(in.read(reinterpret_cast<char*>(offsets_.data()), h.count * sizeof(std::uint64_t)));
+    // Offsets must be increasing and the last record must still end inside the file
+    for (std::size_t i = 1; ok && i < offsets_.size(); ++i) ok = offsets_[i] > offsets_[i - 1];
+    if (ok && !offsets_.empty()) ok = recordEnd(offsets_.back()) != 0;
+    if (!ok) offsets_.clear();
+    return ok;
+}
+
+void CommandLogReader::saveIndex(const std::string& path) const {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return;
+        IndexHeader h{};
+        std::memcpy(h.magic, kIndexMagic, sizeof(kIndexMagic));
+        h.logSize = size_;
+        h.logMtimeNs = mtimeNs_;
+        h.count = offsets_.size();
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(offsets_.data()), offsets_.size() * sizeof(std::uint64_t));
+        if (!out) {
+            out.close();
+            ::unlink(tmp.c_str());
+            return;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) ::unlink(tmp.c_str());
+}
+
+std::string_view CommandLogReader::field(std::uint64_t offset) const {
+    std::uint32_t len = 0;
+    std::memcpy(&len, map_ + offset, sizeof(len));
+    return {map_ + offset + sizeof(len), len};
+}
+
+std::string_view CommandLogReader::command(std::size_t i) const {
+    if (i >= offsets_.size()) throw std::out_of_range("Command log record " + std::to_string(i));
+    return field(offsets_[i]);
+}
+
+std::string_view CommandLogReader::response(std::size_t i) const {
+    std::string_view cmd = command(i);
+    return field(offsets_[i] + sizeof(std::uint32_t) + cmd.size());
+}
+
+std::vector<std::size_t> CommandLogReader::find(std::string_view cmd) const {
+    std::vector<std::size_t> hits;
+    for (std::size_t i = 0; i < offsets_.size(); ++i) {
+        if (command(i) == cmd) hits.push_back(i);
+    }
+    return hits;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Command/response log as written by MeasurementManager::saveToBinaryFile.
+//
+// Each record is stored back to back in host byte order:
+//   uint32 commandLength, command bytes, uint32 responseLength, response bytes
+// There is no file header, so records can only be found by walking the file;
+// CommandLogReader does that once and keeps the offsets in a sidecar index.
+
+// One command and the response it produced
+using CommandRecord = std::pair<std::string, std::string>;
+
+// Write records in the log format (replaces an existing file)
+void writeCommandLog(const std::string& path, const std::vector<CommandRecord>& records);
+
+// Memory-mapped random-access reader of a command/response log.
+//
+// The record offsets are loaded from "<path>.idx" when that index matches the
+// log's size and modification time; otherwise they are rebuilt by one scan and
+// the index is rewritten. A truncated last record (interrupted write) is ignored.
+class CommandLogReader {
+public:
+    // Map the log and load or build its index; useIndex = false always rescans
+    explicit CommandLogReader(const std::string& path, bool useIndex = true);
+    ~CommandLogReader();
+
+    CommandLogReader(const CommandLogReader&) = delete;
+    CommandLogReader& operator=(const CommandLogReader&) = delete;
+
+    // Number of complete records
+    std::size_t size() const;
+
+    // Command and response of record i, viewing the mapping (throws if out of range)
+    std::string_view command(std::size_t i) const;
+    std::string_view response(std::size_t i) const;
+
+    // Indices of all records whose command is exactly cmd
+    std::vector<std::size_t> find(std::string_view cmd) const;
+
+    // Whether the offsets came from a valid sidecar index
+    bool indexLoaded() const;
+
+    // Sidecar index path for a log
+    static std::string indexPath(const std::string& logPath);
+
+private:
+    // Walk the records and collect their offsets
+    void scan();
+
+    // End offset of the record at offset, 0 if it is incomplete
+    std::uint64_t recordEnd(std::uint64_t offset) const;
+
+    // Read offsets from the sidecar, false if it is missing or stale
+    bool loadIndex(const std::string& path);
+
+    // Best-effort write of the sidecar (the log directory may be read-only)
+    void saveIndex(const std::string& path) const;
+
+    // Length-prefixed field at offset
+    std::string_view field(std::uint64_t offset) const;
+
+    const char* map_;
+    std::size_t size_;
+    std::int64_t mtimeNs_;
+    std::vector<std::uint64_t> offsets_;   // Start of every record
+    bool indexLoaded_;
+};
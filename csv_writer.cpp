@@ -0,0 +1,180 @@
+#include "csv_writer.hpp"
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Monotonic time for the flush interval
+static std::int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* CsvStreamWriter::header() {
+    return "Timestamp,Vendor,Model,Serial,Firmware,Voltage,Current,Resistance,SettleTime,SetVoltage\n";
+}
+
+// Open exclusively so an existing run is never overwritten
+CsvStreamWriter::CsvStreamWriter(const std::string& path, const CsvFlushPolicy& flush, FsyncPolicy sync)
+    : path_(path), flushPolicy_(flush), syncPolicy_(sync), fd_(-1), rows_(0), rowsSinceFlush_(0),
+      lastFlushNs_(steadyNs()), lastSecond_(INT64_MIN), syncPending_(false), stopping_(false) {
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ < 0) throw std::runtime_error("Failed to create " + path + ": " + std::strerror(errno));
+
+    buf_.reserve(flushPolicy_.bufferBytes + 512);
+    buf_ += header();
+    if (syncPolicy_ == FsyncPolicy::OnFlush) syncThread_ = std::thread(&CsvStreamWriter::syncLoop, this);
+}
+
+// Never lose buffered rows on scope exit
+CsvStreamWriter::~CsvStreamWriter() {
+    try {
+        close();
+    } catch (...) {}
+}
+
+const std::string& CsvStreamWriter::path() const {
+    return path_;
+}
+
+std::size_t CsvStreamWriter::rows() const {
+    return rows_;
+}
+
+// Shortest representation that parses back to the same double
+void CsvStreamWriter::appendDouble(double value) {
+    char tmp[32];
+    auto [end, ec] = std::to_chars(tmp, tmp + sizeof(tmp), value);
+    buf_.append(tmp, ec == std::errc() ? end - tmp : 0);
+}
+
+// Take one sample's fields from the columns
+void CsvStreamWriter::appendRow(const DataManager& data, std::size_t index) {
+    appendRow(data.wallNs()[index], data.instruments()[data.instrumentIndex()[index]],
+              data.voltages()[index], data.currents()[index], data.resistances()[index],
+              data.settleTimes()[index], data.setVoltages()[index]);
+}
+
+// Format one row into the buffer and flush if the policy says so
+void CsvStreamWriter::appendRow(std::int64_t wallNs, const InstrumentInfo& inst, double voltage, double current,
+                                double resistance, double settleTime, double setVoltage) {
+    std::int64_t second = wallNs / 1000000000;
+    if (second != lastSecond_) {
+        stamp_ = DataManager::formatTimestamp(wallNs);
+        lastSecond_ = second;
+    }
+
+    buf_ += stamp_;
+    buf_ += ',';
+    buf_ += inst.vendor;
+    buf_ += ',';
+    buf_ += inst.model;
+    buf_ += ',';
+    buf_ += inst.serial;
+    buf_ += ',';
+    buf_ += inst.firmware;
+    buf_ += ',';
+    appendDouble(voltage);
+    buf_ += ',';
+    appendDouble(current);
+    buf_ += ',';
+    appendDouble(resistance);
+    buf_ += ',';
+    appendDouble(settleTime);
+    buf_ += ',';
+    appendDouble(setVoltage);
+    buf_ += '\n';
+    ++rows_;
+    ++rowsSinceFlush_;
+
+    bool due = buf_.size() >= flushPolicy_.bufferBytes ||
+               (flushPolicy_.everyRows && rowsSinceFlush_ >= flushPolicy_.everyRows) ||
+               (flushPolicy_.everySeconds > 0 &&
+                steadyNs() - lastFlushNs_ >= static_cast<std::int64_t>(flushPolicy_.everySeconds * 1e9));
+    if (due) flush();
+}
+
+// Hand the buffer to the kernel; the disk sync (if any) happens in the background
+void CsvStreamWriter::flush() {
+    if (fd_ < 0) return;
+    std::size_t done = 0;
+    while (done < buf_.size()) {
+        ssize_t n = ::write(fd_, buf_.data() + done, buf_.size() - done);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error("Write to " + path_ + " failed: " + std::strerror(errno));
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    buf_.clear();
+    rowsSinceFlush_ = 0;
+    lastFlushNs_ = steadyNs();
+
+    if (syncPolicy_ == FsyncPolicy::OnFlush) {
+        std::lock_guard<std::mutex> lock(syncMutex_);
+        syncPending_ = true;
+        syncCv_.notify_one();
+    }
+}
+
+// Final flush, sync and close. A failed write still stops the sync thread and
+// closes the file (the unwritten rows are dropped) before the error is rethrown.
+void CsvStreamWriter::close() {
+    if (fd_ < 0) return;
+    std::exception_ptr error;
+    try {
+        flush();
+    } catch (...) {
+        error = std::current_exception();
+        buf_.clear();
+    }
+    if (syncThread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(syncMutex_);
+            stopping_ = true;
+            syncCv_.notify_one();
+        }
+        syncThread_.join();
+    }
+    if (!error && syncPolicy_ != FsyncPolicy::Never) ::fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+    if (error) std::rethrow_exception(error);
+}
+
+// Coalesce sync requests: one fdatasync covers every flush made before it
+void CsvStreamWriter::syncLoop() {
+    std::unique_lock<std::mutex> lock(syncMutex_);
+    while (true) {
+        syncCv_.wait(lock, [&] { return syncPending_ || stopping_; });
+        if (!syncPending_ && stopping_) return;
+        syncPending_ = false;
+        lock.unlock();
+        ::fdatasync(fd_);
+        lock.lock();
+    }
+}
+
+// Run start time in the name; a counter suffix resolves clashes within one second
+std::string uniqueRunPath(const std::string& dir, const std::string& base, const std::string& ext) {
+    std::time_t t = std::time(nullptr);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+
+    std::string stem = dir + "/" + base + "_" + stamp;
+    std::string path = stem + "." + ext;
+    for (int i = 1; std::filesystem::exists(path); ++i)
+        path = stem + "_" + std::to_string(i) + "." + ext;
+    return path;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "data_manager.hpp"
+
+// When buffered rows are written to the file
+struct CsvFlushPolicy {
+    std::size_t bufferBytes = 64 * 1024;  // Write out once the buffer holds this much
+    std::size_t everyRows = 0;            // Also after this many rows (0 = off)
+    double everySeconds = 1.0;            // And at least this often while rows arrive (0 = off)
+};
+
+// When written data is forced to stable storage
+enum class FsyncPolicy {
+    Never,     // Leave it to the kernel
+    OnFlush,   // fdatasync after every flush, on a background thread
+    OnClose    // fdatasync once when the file is closed
+};
+
+// Appends CSV rows to a file while a run is in progress. Rows go to an
+// in-memory buffer, numbers are formatted with round-trip exact to_chars,
+// and the buffer is written out according to the flush policy, so a crash
+// loses at most one flush interval.
+class CsvStreamWriter {
+public:
+    // Create the file (fails if it already exists) and write the header row
+    CsvStreamWriter(const std::string& path, const CsvFlushPolicy& flush = {},
+                    FsyncPolicy sync = FsyncPolicy::OnFlush);
+    ~CsvStreamWriter();
+
+    CsvStreamWriter(const CsvStreamWriter&) = delete;
+    CsvStreamWriter& operator=(const CsvStreamWriter&) = delete;
+
+    // Append sample `index` of a DataManager
+    void appendRow(const DataManager& data, std::size_t index);
+
+    // Append one row from its fields
+    void appendRow(std::int64_t wallNs, const InstrumentInfo& inst, double voltage, double current,
+                   double resistance, double settleTime, double setVoltage);
+
+    // Write buffered rows to the file now
+    void flush();
+
+    // Flush, sync according to policy and close the file
+    void close();
+
+    const std::string& path() const;
+    std::size_t rows() const;
+
+    // Column header shared with DataManager::saveCSV
+    static const char* header();
+
+private:
+    // Append a double in shortest round-trip form
+    void appendDouble(double value);
+
+    // Background fdatasync loop for FsyncPolicy::OnFlush
+    void syncLoop();
+
+    std::string path_;
+    CsvFlushPolicy flushPolicy_;
+    FsyncPolicy syncPolicy_;
+    int fd_;
+    std::string buf_;
+    std::size_t rows_;
+    std::size_t rowsSinceFlush_;
+    std::int64_t lastFlushNs_;
+
+    // Timestamps only change once per second
+    std::int64_t lastSecond_;
+    std::string stamp_;
+
+    std::thread syncThread_;
+    std::mutex syncMutex_;
+    std::condition_variable syncCv_;
+    bool syncPending_;
+    bool stopping_;
+};
+
+// Per-run file name that never overwrites: <dir>/<base>_YYYYmmdd_HHMMSS[_N].<ext>
+std::string uniqueRunPath(const std::string& dir, const std::string& base, const std::string& ext);
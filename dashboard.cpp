@@ -0,0 +1,339 @@
+#include "dashboard.hpp"
+#include "profiler.hpp"
+#include <ncurses.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdarg>
+#include <iostream>
+#include <streambuf>
+
+using Clock = std::chrono::steady_clock;
+
+// Collects what is written to std::cerr while the dashboard owns the screen
+class RunDashboard::LineCapture : public std::streambuf {
+public:
+    // Everything captured so far
+    std::string text() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return text_;
+    }
+
+    // Latest complete line and the number of lines
+    std::string last(std::size_t& lines) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lines = lines_;
+        return last_;
+    }
+
+protected:
+    int overflow(int c) override {
+        if (c == traits_type::eof()) return traits_type::not_eof(c);
+        char ch = static_cast<char>(c);
+        std::lock_guard<std::mutex> lock(mutex_);
+        put(ch);
+        return c;
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::streamsize i = 0; i < n; ++i) put(s[i]);
+        return n;
+    }
+
+private:
+    void put(char ch) {
+        text_ += ch;
+        if (ch != '\n') {
+            line_ += ch;
+        } else if (!line_.empty()) {
+            last_ = std::move(line_);
+            line_.clear();
+            ++lines_;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::string text_;
+    std::string line_;
+    std::string last_;
+    std::size_t lines_ = 0;
+};
+
+// UI thread only: what has been received and what is on screen
+struct RunDashboard::State {
+    explicit State(std::size_t history) : ring(std::max<std::size_t>(history, 2)) {}
+
+    std::vector<DashboardSample> ring;   // Latest samples, oldest overwritten
+    std::size_t received = 0;
+    std::vector<std::string> shown;      // Rows as last drawn
+    std::vector<std::string> phases;     // Profiler rows, refreshed once per second
+    Clock::time_point phasesAt{};
+    Clock::time_point started = Clock::now();
+
+    // i-th newest sample (0 = latest); i < min(received, ring.size())
+    const DashboardSample& recent(std::size_t i) const {
+        return ring[(received - 1 - i) % ring.size()];
+    }
+    std::size_t kept() const { return std::min(received, ring.size()); }
+};
+
+static std::string format(const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    std::vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+static std::string clockText(double seconds) {
+    long s = static_cast<long>(seconds + 0.5);
+    if (s >= 3600) return format("%ld:%02ld:%02ld", s / 3600, s / 60 % 60, s % 60);
+    return format("%02ld:%02ld", s / 60, s % 60);
+}
+
+// Density ramp, one character per value, scaled to the range shown
+static std::string sparkline(const std::vector<double>& values, double& lo, double& hi) {
+    static const char kRamp[] = " .:-=+*#%@";
+    lo = INFINITY;
+    hi = -INFINITY;
+    for (double y : values) {
+        if (!std::isfinite(y)) continue;
+        lo = std::min(lo, y);
+        hi = std::max(hi, y);
+    }
+    std::string line(values.size(), ' ');
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (!std::isfinite(values[i])) continue;
+        double f = hi > lo ? (values[i] - lo) / (hi - lo) : 0.5;
+        line[i] = kRamp[1 + static_cast<int>(f * (sizeof(kRamp) - 3) + 0.5)];
+    }
+    return line;
+}
+
+// Profiled acquisition phases by total time, mean latency each
+static std::vector<std::string> phaseRows() {
+    std::vector<std::pair<std::string, PhaseStats>> phases;
+    for (const auto& [name, s] : Profiler::instance().phases()) {
+        if (name.rfind("sweep.", 0) == 0 || name.rfind("scpi.", 0) == 0 || name.rfind("grid.", 0) == 0 ||
+            name.rfind("journal.", 0) == 0)
+            phases.emplace_back(name, s);
+    }
+    std::sort(phases.begin(), phases.end(),
+              [](const auto& a, const auto& b) { return a.second.totalNs > b.second.totalNs; });
+    std::vector<std::string> rows;
+    for (std::size_t i = 0; i < phases.size() && i < 5; ++i) {
+        const PhaseStats& s = phases[i].second;
+        rows.push_back(format("        %-20s %9.3f ms mean %9.3f ms max %8llu calls", phases[i].first.c_str(),
+                              s.totalNs / 1e6 / std::max<std::uint64_t>(s.count, 1), s.maxNs / 1e6,
+                              static_cast<unsigned long long>(s.count)));
+    }
+    return rows;
+}
+
+RunDashboard::RunDashboard(DashboardConfig config) : config_(std::move(config)), queue_(config_.capacity) {}
+
+RunDashboard::~RunDashboard() {
+    stop();
+}
+
+void RunDashboard::start() {
+    if (thread_.joinable()) return;
+    capture_ = std::make_unique<LineCapture>();
+    savedCerr_ = std::cerr.rdbuf(capture_.get());
+    stopping_ = false;
+    thread_ = std::thread(&RunDashboard::run, this);
+}
+
+void RunDashboard::stop() {
+    if (!thread_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+    std::cerr.rdbuf(savedCerr_);
+    savedCerr_ = nullptr;
+    std::cerr << capture_->text() << std::flush;
+}
+
+void RunDashboard::push(const DashboardSample& sample) {
+    if (!queue_.tryPush(sample)) dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RunDashboard::setLinkStats(const ScpiLinkStats& s) {
+    timeouts_.store(s.timeouts, std::memory_order_relaxed);
+    resets_.store(s.resets + s.shortReplies, std::memory_order_relaxed);
+    garbled_.store(s.garbled, std::memory_order_relaxed);
+    retries_.store(s.retries, std::memory_order_relaxed);
+}
+
+DashboardStats RunDashboard::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    DashboardStats s = stats_;
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    return s;
+}
+
+// UI thread: every ncurses call of the dashboard happens here
+void RunDashboard::run() {
+    SCREEN* screen = nullptr;
+    if (config_.terminal) {
+        screen = newterm(nullptr, config_.terminal, stdin);
+        if (!screen) return;
+        set_term(screen);
+    } else {
+        initscr();
+    }
+    noecho();
+    cbreak();
+    nodelay(stdscr, TRUE);
+    keypad(stdscr, TRUE);
+    curs_set(0);
+    clear();
+
+    State state(config_.history);
+    auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(config_.frameSeconds));
+    auto next = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        bool last = stopping_;
+        lock.unlock();
+        auto t0 = Clock::now();
+        std::size_t drawn = 0;
+        {
+            ScopedTimer t("dashboard.frame");
+            frame(state, drawn);
+        }
+        double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+        lock.lock();
+        ++stats_.frames;
+        stats_.rowsDrawn += drawn;
+        stats_.samples = state.received;
+        stats_.renderSeconds += dt;
+        if (last) break;
+
+        // Fixed cadence; frames missed while the UI thread was descheduled are skipped, not caught up
+        next += interval;
+        if (next < Clock::now()) next = Clock::now() + interval;
+        cv_.wait_until(lock, next, [&] { return stopping_; });
+    }
+    lock.unlock();
+
+    curs_set(1);
+    endwin();
+    if (screen) delscreen(screen);
+}
+
+// Drain new samples, compose every row and rewrite the ones that changed
+void RunDashboard::frame(State& st, std::size_t& drawn) {
+    DashboardSample sample;
+    while (queue_.tryPop(sample)) st.ring[st.received++ % st.ring.size()] = sample;
+
+    if (!config_.terminal) {
+        for (int c = getch(); c != ERR; c = getch())
+            if (c == KEY_RESIZE) {
+                clear();
+                st.shown.clear();
+            }
+    }
+
+    int cols = std::max(COLS, 20);
+    std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    std::size_t count = st.received + dropped;
+    double elapsed = std::chrono::duration<double>(Clock::now() - st.started).count();
+
+    // Rate, point interval and settling over the latest samples
+    std::size_t window = std::min<std::size_t>(st.kept(), 64);
+    double rate = 0.0, interval = 0.0, settle = 0.0;
+    if (window >= 2) {
+        double span = static_cast<double>(st.recent(0).monotonicNs - st.recent(window - 1).monotonicNs);
+        if (span > 0) {
+            interval = span / (window - 1) / 1e6;
+            rate = 1e3 / interval;
+        }
+    }
+    for (std::size_t i = 0; i < window; ++i) settle += st.recent(i).settleTime;
+    if (window) settle = settle / window * 1e3;
+
+    std::vector<std::string> rows;
+    rows.push_back(config_.title);
+    rows.emplace_back();
+    if (config_.total) {
+        int barWidth = std::clamp(cols - 40, 10, 50);
+        double done = std::min(1.0, static_cast<double>(count) / config_.total);
+        int filled = static_cast<int>(done * barWidth);
+        rows.push_back(format("Point   %zu / %zu  [%s%s] %3.0f %%", count, config_.total,
+                              std::string(filled, '#').c_str(), std::string(barWidth - filled, '.').c_str(),
+                              done * 100));
+    } else {
+        rows.push_back(format("Point   %zu", count));
+    }
+    std::string eta = "-";
+    if (config_.total > count && rate > 0) eta = clockText((config_.total - count) / rate);
+    rows.push_back(rate > 0 ? format("Rate    %.1f points/s   Elapsed %s   ETA %s", rate, clockText(elapsed).c_str(),
+                                     eta.c_str())
+                            : format("Rate    -   Elapsed %s", clockText(elapsed).c_str()));
+    rows.emplace_back();
+
+    const auto& l = config_.labels;
+    if (st.received) {
+        const DashboardSample& s = st.recent(0);
+        rows.push_back(format("Latest  %s = %.6g   %s = %.6g   %s = %.6g", l[0].c_str(), s.x, l[1].c_str(), s.y,
+                              l[2].c_str(), s.z));
+        std::size_t n = std::min(st.kept(), static_cast<std::size_t>(std::max(cols - 9, 1)));
+        std::vector<double> ys(n);
+        for (std::size_t i = 0; i < n; ++i) ys[i] = st.recent(n - 1 - i).y;
+        double lo, hi;
+        rows.push_back("Trend   " + sparkline(ys, lo, hi));
+        rows.push_back(std::isfinite(lo) ? format("        %s %.4g .. %.4g", l[1].c_str(), lo, hi) : "");
+    } else {
+        rows.push_back("Latest  waiting for the first point");
+        rows.emplace_back();
+        rows.emplace_back();
+    }
+    rows.emplace_back();
+
+    rows.push_back(window >= 2 ? format("Timing  %.2f ms per point   %.2f ms settling", interval, settle)
+                               : "Timing  -");
+    if (Profiler::instance().enabled() && Clock::now() - st.phasesAt >= std::chrono::seconds(1)) {
+        st.phases = phaseRows();
+        st.phasesAt = Clock::now();
+    }
+    rows.insert(rows.end(), st.phases.begin(), st.phases.end());
+    rows.emplace_back();
+
+    rows.push_back(format("Faults  timeouts %llu   resets %llu   garbled %llu   retries %llu   dropped %llu",
+                          static_cast<unsigned long long>(timeouts_.load(std::memory_order_relaxed)),
+                          static_cast<unsigned long long>(resets_.load(std::memory_order_relaxed)),
+                          static_cast<unsigned long long>(garbled_.load(std::memory_order_relaxed)),
+                          static_cast<unsigned long long>(retries_.load(std::memory_order_relaxed)),
+                          static_cast<unsigned long long>(dropped)));
+    std::size_t messages = 0;
+    std::string message = capture_ ? capture_->last(messages) : "";
+    rows.push_back(messages ? format("Log     (%zu) %s", messages, message.c_str()) : "Log     -");
+
+    for (auto& row : rows)
+        if (row.size() >= static_cast<std::size_t>(cols)) row.resize(cols - 1);
+
+    // Only changed rows go to the terminal; clear() would repaint every cell
+    if (config_.fullRedraw) {
+        clear();
+        st.shown.clear();
+    }
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        if (i < st.shown.size() && st.shown[i] == rows[i]) continue;
+        mvaddstr(static_cast<int>(i), 0, rows[i].c_str());
+        clrtoeol();
+        ++drawn;
+    }
+    for (std::size_t i = rows.size(); i < st.shown.size(); ++i) {
+        move(static_cast<int>(i), 0);
+        clrtoeol();
+        ++drawn;
+    }
+    st.shown = std::move(rows);
+    refresh();
+}
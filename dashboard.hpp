@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pipeline.hpp"
+#include "scpi_session.hpp"
+
+// One measured point as the dashboard shows it
+struct DashboardSample {
+    double x;                    // Source value (voltage, bias)
+    double y;                    // Measured value (current, Cp), drawn as the sparkline
+    double z;                    // Derived value (resistance, D)
+    double settleTime;           // Seconds spent settling
+    std::int64_t monotonicNs;    // When it was measured (steady_clock)
+};
+
+struct DashboardConfig {
+    std::string title;
+    std::size_t total = 0;                                  // Points expected (0: no progress bar or ETA)
+    std::array<std::string, 3> labels{"V", "I", "R"};       // Names of x, y, z
+    double frameSeconds = 0.1;                              // Redraw interval
+    std::size_t history = 512;                              // Samples kept for the sparkline and rate
+    std::size_t capacity = 4096;                            // Samples queued between two frames
+    bool fullRedraw = false;                                // clear() every frame (for comparison only)
+    FILE* terminal = nullptr;                               // Draw here instead of the controlling terminal
+};
+
+// What the UI thread did
+struct DashboardStats {
+    std::uint64_t frames = 0;
+    std::uint64_t rowsDrawn = 0;     // Rows rewritten; unchanged rows are skipped
+    std::uint64_t samples = 0;       // Samples shown
+    std::uint64_t dropped = 0;       // Samples lost to a full queue
+    double renderSeconds = 0.0;      // Time spent composing and drawing frames
+};
+
+// Live ncurses view of a running sweep: progress, rate and ETA, latest values,
+// a sparkline, latencies and fault counters. A UI thread owns the terminal and
+// redraws on a fixed frame interval, rewriting only the rows that changed.
+// The acquisition thread only hands over samples through a lock-free queue
+// (dropped, not waited for, if the UI falls behind) and stores link counters
+// in atomics, so drawing never holds up a measurement.
+//
+// While it runs, std::cerr is captured: the latest message is shown on screen
+// and everything is written to the real stream again by stop().
+class RunDashboard {
+public:
+    explicit RunDashboard(DashboardConfig config);
+    ~RunDashboard();
+
+    RunDashboard(const RunDashboard&) = delete;
+    RunDashboard& operator=(const RunDashboard&) = delete;
+
+    // Take over the terminal and start drawing
+    void start();
+
+    // Draw a last frame, give the terminal back and replay captured messages
+    void stop();
+
+    // Acquisition thread: one new point
+    void push(const DashboardSample& sample);
+
+    // Acquisition thread: the session's fault counters so far
+    void setLinkStats(const ScpiLinkStats& stats);
+
+    DashboardStats stats() const;
+
+private:
+    class LineCapture;
+    struct State;
+
+    void run();
+    void frame(State& state, std::size_t& drawn);
+
+    DashboardConfig config_;
+    SpscQueue<DashboardSample> queue_;
+    std::atomic<std::uint64_t> dropped_{0};
+    std::atomic<std::uint64_t> timeouts_{0};
+    std::atomic<std::uint64_t> resets_{0};
+    std::atomic<std::uint64_t> garbled_{0};
+    std::atomic<std::uint64_t> retries_{0};
+
+    std::unique_ptr<LineCapture> capture_;
+    std::streambuf* savedCerr_ = nullptr;
+
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+    DashboardStats stats_;
+};
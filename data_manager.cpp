@@ -1,65 +1,245 @@
 #include "data_manager.hpp"
-#include <fstream>
+#include "csv_writer.hpp"
+#include <charconv>
 #include <chrono>
-#include <iomanip>
+#include <cmath>
+#include <ctime>
+#include <fstream>
 #include <sstream>
 #include <filesystem>
 #include <iostream> 
+#include <stdexcept>
 
-// Add one measurement to the internal data storage
-void DataManager::addMeasurement(const std::string& idn, double voltage, double current) {
+// Split an IDN reply into vendor, model, serial and firmware
+InstrumentInfo DataManager::parseIdn(const std::string& idn) {
     std::stringstream ss(idn);
-    std::string vendor, model, serial, firmware;
-
-    // Parse instrument identification string
-    if (!std::getline(ss, vendor, ',')) vendor = "N/A";
-    if (!std::getline(ss, model, ',')) model = "N/A";
-    if (!std::getline(ss, serial, ',')) serial = "N/A";
-    if (!std::getline(ss, firmware)) firmware = "N/A";
-
-    MeasurementData m;
-    m.timestamp = getTimestamp();
-    m.vendor = vendor;
-    m.model = model;
-    m.serial = serial;
-    m.firmware = firmware;
-    m.voltage = voltage;
-    m.current = current;
-    m.resistance = (current != 0.0) ? voltage / current : 0.0;  // Avoid division by zero
-    data.push_back(m);
-}
-
-// Save collected measurements as CSV file
-void DataManager::saveCSV(const std::string& full_path) const {
-    std::filesystem::create_directories(std::filesystem::path(full_path).parent_path());
+    InstrumentInfo info;
+    info.idn = idn;
+    if (!std::getline(ss, info.vendor, ',')) info.vendor = "N/A";
+    if (!std::getline(ss, info.model, ',')) info.model = "N/A";
+    if (!std::getline(ss, info.serial, ',')) info.serial = "N/A";
+    if (!std::getline(ss, info.firmware)) info.firmware = "N/A";
+    return info;
+}
 
-    std::ofstream out(full_path);
-    if (!out) {
-        std::cerr << "[!] Failed to open file for writing: " << full_path << std::endl;
-        return;
+// Nanoseconds since the epoch of the given clock
+template <typename ClockT>
+static std::int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(ClockT::now().time_since_epoch()).count();
+}
+
+// The IDN is the same for every point of a run, so the last match is checked first
+std::uint32_t DataManager::intern(const std::string& idn) {
+    if (lastInstrument_ < instruments_.size() && instruments_[lastInstrument_].idn == idn)
+        return lastInstrument_;
+    for (std::uint32_t i = 0; i < instruments_.size(); ++i) {
+        if (instruments_[i].idn == idn) return lastInstrument_ = i;
     }
+    instruments_.push_back(parseIdn(idn));
+    return lastInstrument_ = static_cast<std::uint32_t>(instruments_.size() - 1);
+}
+
+// Append one sample to every column
+void DataManager::addMeasurement(const std::string& idn, double voltage, double current, double settleTime,
+                                 double setVoltage) {
+    addMeasurement(idn, nowNs<std::chrono::steady_clock>(), nowNs<std::chrono::system_clock>(), voltage, current,
+                   settleTime, setVoltage);
+}
+
+void DataManager::addMeasurement(const std::string& idn, std::int64_t monotonicNs, std::int64_t wallNs,
+                                 double voltage, double current, double settleTime, double setVoltage) {
+    instrument_.push_back(intern(idn));
+    monotonic_.push_back(monotonicNs);
+    wall_.push_back(wallNs);
+    setVoltage_.push_back(setVoltage);
+    voltage_.push_back(voltage);
+    current_.push_back(current);
+    resistance_.push_back(resistance(voltage, current));
+    settle_.push_back(settleTime);
+}
 
-    // Write header row
-    out << "Timestamp,Vendor,Model,Serial,Firmware,Voltage,Current,Resistance\n";
-    for (const auto& m : data) {
-        out << m.timestamp << "," << m.vendor << "," << m.model << "," << m.serial << "," << m.firmware
-            << "," << m.voltage << "," << m.current << "," << m.resistance << "\n";
+double DataManager::resistance(double voltage, double current) {
+    return (current != 0.0) ? voltage / current : 0.0;  // Avoid division by zero
+}
+
+// Reserve by plan so a run never reallocates mid-sweep
+void DataManager::reserve(std::size_t points) {
+    monotonic_.reserve(points);
+    wall_.reserve(points);
+    setVoltage_.reserve(points);
+    voltage_.reserve(points);
+    current_.reserve(points);
+    resistance_.reserve(points);
+    settle_.reserve(points);
+    instrument_.reserve(points);
+}
+
+// Forget everything stored so far
+void DataManager::clear() {
+    instruments_.clear();
+    lastInstrument_ = 0;
+    monotonic_.clear();
+    wall_.clear();
+    setVoltage_.clear();
+    voltage_.clear();
+    current_.clear();
+    resistance_.clear();
+    settle_.clear();
+    instrument_.clear();
+}
+
+std::size_t DataManager::size() const {
+    return voltage_.size();
+}
+
+// Save collected measurements as CSV file (replaces an existing file)
+void DataManager::saveCSV(const std::string& full_path) const {
+    try {
+        std::filesystem::remove(full_path);
+        CsvFlushPolicy policy;
+        policy.bufferBytes = 1 << 20;
+        policy.everySeconds = 0;
+        CsvStreamWriter out(full_path, policy, FsyncPolicy::OnClose);
+        for (std::size_t i = 0; i < size(); ++i) out.appendRow(*this, i);
+        out.close();
+    } catch (const std::exception& e) {
+        std::cerr << "[!] Failed to write " << full_path << ": " << e.what() << std::endl;
+        return;
     }
 
     std::cout << "[✓] Saved to " << full_path << std::endl;
 }
 
-// Return const reference to stored data
-const std::vector<MeasurementData>& DataManager::getData() const {
-    return data;
+// Materialize one row
+MeasurementData DataManager::row(std::size_t index) const {
+    const InstrumentInfo& inst = instruments_[instrument_[index]];
+    return {formatTimestamp(wall_[index]), inst.vendor, inst.model, inst.serial, inst.firmware,
+            setVoltage_[index], voltage_[index], current_[index], resistance_[index], settle_[index]};
+}
+
+std::span<const std::int64_t> DataManager::monotonicNs() const { return monotonic_; }
+std::span<const std::int64_t> DataManager::wallNs() const { return wall_; }
+std::span<const double> DataManager::setVoltages() const { return setVoltage_; }
+std::span<const double> DataManager::voltages() const { return voltage_; }
+std::span<const double> DataManager::currents() const { return current_; }
+std::span<const double> DataManager::resistances() const { return resistance_; }
+std::span<const double> DataManager::settleTimes() const { return settle_; }
+std::span<const std::uint32_t> DataManager::instrumentIndex() const { return instrument_; }
+
+const std::vector<InstrumentInfo>& DataManager::instruments() const {
+    return instruments_;
+}
+
+// Human-readable local time, thread-safe (localtime_r)
+std::string DataManager::formatTimestamp(std::int64_t wallNs) {
+    std::time_t t = static_cast<std::time_t>(wallNs / 1000000000);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return buf;
+}
+
+GridData& DataManager::beginGrid(std::vector<std::string> axisNames, std::vector<std::vector<double>> axisValues,
+                                 std::vector<std::string> channels) {
+    grid_ = GridData(std::move(axisNames), std::move(axisValues), std::move(channels));
+    return grid_;
 }
 
-// Get current system timestamp in human-readable format
-std::string DataManager::getTimestamp() const {
-    auto now = std::chrono::system_clock::now();
-    std::time_t t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&t), "%Y-%m-%d %H:%M:%S");
-    return ss.str();
+GridData& DataManager::grid() { return grid_; }
+const GridData& DataManager::grid() const { return grid_; }
+
+// Allocate every cell up front so filling the grid never reallocates
+GridData::GridData(std::vector<std::string> axisNames, std::vector<std::vector<double>> axisValues,
+                   std::vector<std::string> channels)
+    : axisNames_(std::move(axisNames)), axisValues_(std::move(axisValues)), channels_(std::move(channels)) {
+    if (axisNames_.size() != axisValues_.size()) throw std::invalid_argument("Grid axis names and values differ");
+    if (channels_.empty()) throw std::invalid_argument("Grid needs at least one channel");
+    shape_.resize(axisValues_.size());
+    strides_.resize(axisValues_.size());
+    std::size_t cells = 1;
+    for (std::size_t a = axisValues_.size(); a-- > 0;) {
+        shape_[a] = axisValues_[a].size();
+        strides_[a] = cells;
+        cells *= shape_[a];
+    }
+    values_.assign(cells * channels_.size(), std::numeric_limits<double>::quiet_NaN());
+}
+
+std::size_t GridData::dimensions() const { return shape_.size(); }
+const std::vector<std::size_t>& GridData::shape() const { return shape_; }
+std::size_t GridData::cells() const { return channels_.empty() ? 0 : values_.size() / channels_.size(); }
+std::size_t GridData::filled() const { return filled_; }
+const std::vector<std::string>& GridData::axisNames() const { return axisNames_; }
+const std::vector<double>& GridData::axisValues(std::size_t axis) const { return axisValues_.at(axis); }
+const std::vector<std::string>& GridData::channels() const { return channels_; }
+std::span<const double> GridData::values() const { return values_; }
+
+std::size_t GridData::offset(std::span<const std::size_t> index) const {
+    if (index.size() != shape_.size()) throw std::out_of_range("Grid index has wrong number of axes");
+    std::size_t cell = 0;
+    for (std::size_t a = 0; a < index.size(); ++a) {
+        if (index[a] >= shape_[a]) throw std::out_of_range("Grid index out of range");
+        cell += index[a] * strides_[a];
+    }
+    return cell * channels_.size();
 }
 
+void GridData::set(std::span<const std::size_t> index, std::span<const double> values) {
+    if (values.size() != channels_.size()) throw std::invalid_argument("Grid cell needs one value per channel");
+    double* cell = &values_[offset(index)];
+    if (std::isnan(cell[0])) ++filled_;
+    std::copy(values.begin(), values.end(), cell);
+}
+
+std::span<const double> GridData::at(std::span<const std::size_t> index) const {
+    return std::span<const double>(values_).subspan(offset(index), channels_.size());
+}
+
+// Strided walk along one axis
+std::vector<double> GridData::line(std::span<const std::size_t> index, std::size_t axis, std::size_t channel) const {
+    std::vector<std::size_t> at(index.begin(), index.end());
+    at.at(axis) = 0;
+    std::size_t base = offset(at) + channel;
+    std::size_t step = strides_[axis] * channels_.size();
+    std::vector<double> out(shape_[axis]);
+    for (std::size_t i = 0; i < out.size(); ++i) out[i] = values_[base + i * step];
+    return out;
+}
+
+// Cells in storage order; numbers in shortest round-trip form
+void GridData::saveCSV(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to open " + path);
+
+    std::string line;
+    auto appendDouble = [&](double v) {
+        char buf[32];
+        auto res = std::to_chars(buf, buf + sizeof(buf), v);
+        line.append(buf, res.ptr);
+    };
+    for (const auto& name : axisNames_) line += name + ",";
+    for (std::size_t c = 0; c < channels_.size(); ++c) line += channels_[c] + (c + 1 < channels_.size() ? "," : "\n");
+    out << line;
+
+    std::vector<std::size_t> index(shape_.size(), 0);
+    for (std::size_t cell = 0; cell < cells(); ++cell) {
+        line.clear();
+        for (std::size_t a = 0; a < shape_.size(); ++a) {
+            appendDouble(axisValues_[a][index[a]]);
+            line += ',';
+        }
+        for (std::size_t c = 0; c < channels_.size(); ++c) {
+            appendDouble(values_[cell * channels_.size() + c]);
+            line += (c + 1 < channels_.size()) ? ',' : '\n';
+        }
+        out << line;
+
+        // Odometer increment, last axis fastest
+        for (std::size_t a = shape_.size(); a-- > 0;) {
+            if (++index[a] < shape_[a]) break;
+            index[a] = 0;
+        }
+    }
+    if (!out) throw std::runtime_error("Failed to write " + path);
+}
@@ -1,37 +1,151 @@
 #ifndef __DATA__MENEGER__
 #define __DATA__MENEGER__
 
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <string>
 #include <vector>
 
-// Structure to store one measurement record
+// Instrument identification, parsed once from the *IDN? reply
+struct InstrumentInfo {
+    std::string idn;
+    std::string vendor;
+    std::string model;
+    std::string serial;
+    std::string firmware;
+};
+
+// One measurement record, built on demand from the columns (export, display)
 struct MeasurementData {
     std::string timestamp;
     std::string vendor;
     std::string model;
     std::string serial;
     std::string firmware;
+    double setVoltage;   // Programmed source voltage (NaN if unknown)
     double voltage;
     double current;
     double resistance;
+    double settleTime;   // Seconds the source needed to settle before this reading
+};
+
+// Dense N-dimensional result grid (e.g. bias x frequency x AC level). Cells are
+// stored row-major in axis order, last axis fastest, each holding one value per
+// channel; cells that were not measured hold NaN.
+class GridData {
+public:
+    GridData() = default;
+    GridData(std::vector<std::string> axisNames, std::vector<std::vector<double>> axisValues,
+             std::vector<std::string> channels);
+
+    std::size_t dimensions() const;
+    const std::vector<std::size_t>& shape() const;
+    std::size_t cells() const;
+    std::size_t filled() const;   // Cells written so far
+
+    const std::vector<std::string>& axisNames() const;
+    const std::vector<double>& axisValues(std::size_t axis) const;
+    const std::vector<std::string>& channels() const;
+
+    // Position of a cell's first channel in values()
+    std::size_t offset(std::span<const std::size_t> index) const;
+
+    // Store / view the channel values of one cell
+    void set(std::span<const std::size_t> index, std::span<const double> values);
+    std::span<const double> at(std::span<const std::size_t> index) const;
+
+    // Whole array, zero-copy
+    std::span<const double> values() const;
+
+    // One channel along one axis with every other axis fixed at `index`
+    std::vector<double> line(std::span<const std::size_t> index, std::size_t axis, std::size_t channel) const;
+
+    // One row per cell: axis values, then channels (replaces an existing file)
+    void saveCSV(const std::string& path) const;
+
+private:
+    std::vector<std::string> axisNames_;
+    std::vector<std::vector<double>> axisValues_;
+    std::vector<std::string> channels_;
+    std::vector<std::size_t> shape_;
+    std::vector<std::size_t> strides_;   // In cells
+    std::vector<double> values_;
+    std::size_t filled_ = 0;
 };
 
+// Column store of one run: instrument metadata is interned, samples live in
+// contiguous typed columns and strings are only formatted at export time
 class DataManager {
 public:
-    // Add a new measurement
-    void addMeasurement(const std::string& idn, double voltage, double current);
+    // Add a new measurement; the IDN is parsed only the first time it is seen
+    void addMeasurement(const std::string& idn, double voltage, double current, double settleTime = 0.0,
+                        double setVoltage = std::numeric_limits<double>::quiet_NaN());
+
+    // Add a measurement stamped by the caller (samples recorded away from the acquisition thread)
+    void addMeasurement(const std::string& idn, std::int64_t monotonicNs, std::int64_t wallNs, double voltage,
+                        double current, double settleTime, double setVoltage);
+
+    // Derived resistance column value (0 when no current flows)
+    static double resistance(double voltage, double current);
+
+    // Pre-allocate all columns for the planned number of points
+    void reserve(std::size_t points);
+
+    // Drop all samples and instruments
+    void clear();
+
+    // Number of stored samples
+    std::size_t size() const;
 
     // Save all measurements to a CSV file
     void saveCSV(const std::string& full_path) const;
 
-    // Get access to stored measurement data
-    const std::vector<MeasurementData>& getData() const;
+    // Build one row with formatted timestamp and instrument fields
+    MeasurementData row(std::size_t index) const;
+
+    // Zero-copy column views
+    std::span<const std::int64_t> monotonicNs() const;   // steady_clock, for intervals
+    std::span<const std::int64_t> wallNs() const;        // system_clock, for timestamps
+    std::span<const double> setVoltages() const;
+    std::span<const double> voltages() const;
+    std::span<const double> currents() const;
+    std::span<const double> resistances() const;
+    std::span<const double> settleTimes() const;
+    std::span<const std::uint32_t> instrumentIndex() const;
+
+    // Interned instruments referenced by instrumentIndex()
+    const std::vector<InstrumentInfo>& instruments() const;
+
+    // Format a wall-clock timestamp as "YYYY-MM-DD HH:MM:SS" local time
+    static std::string formatTimestamp(std::int64_t wallNs);
+
+    // Split an IDN reply into vendor, model, serial and firmware
+    static InstrumentInfo parseIdn(const std::string& idn);
+
+    // Start a grid run; replaces any previous grid
+    GridData& beginGrid(std::vector<std::string> axisNames, std::vector<std::vector<double>> axisValues,
+                        std::vector<std::string> channels);
+    GridData& grid();
+    const GridData& grid() const;
 
 private:
-    // Get current timestamp in formatted string
-    std::string getTimestamp() const;
+    // Find or add the instrument for an IDN string
+    std::uint32_t intern(const std::string& idn);
+
+    std::vector<InstrumentInfo> instruments_;
+    std::uint32_t lastInstrument_ = 0;
+
+    std::vector<std::int64_t> monotonic_;
+    std::vector<std::int64_t> wall_;
+    std::vector<double> setVoltage_;
+    std::vector<double> voltage_;
+    std::vector<double> current_;
+    std::vector<double> resistance_;
+    std::vector<double> settle_;
+    std::vector<std::uint32_t> instrument_;
 
-    std::vector<MeasurementData> data;
+    GridData grid_;
 };
 
 #endif
@@ -0,0 +1,174 @@
+#include "grid_sweep.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+GridOrder gridOrderCost(const std::vector<SweepAxis>& axes, const std::vector<std::size_t>& nesting,
+                        bool serpentine) {
+    GridOrder order;
+    order.nesting = nesting;
+    order.serpentine = serpentine;
+    std::size_t outer = 1;  // Passes over this loop = product of the outer axis sizes
+    for (std::size_t axis : nesting) {
+        std::size_t n = axes[axis].values.size();
+        std::size_t changes = 0;
+        if (n > 1) changes = serpentine ? outer * (n - 1) : outer * n - 1;
+        order.changes += changes;
+        order.cost += changes * axes[axis].changeCost;
+        outer *= n;
+    }
+    return order;
+}
+
+GridOrder planGridOrder(const std::vector<SweepAxis>& axes, bool serpentine) {
+    std::vector<std::size_t> nesting(axes.size());
+    std::iota(nesting.begin(), nesting.end(), 0);
+    GridOrder best = gridOrderCost(axes, nesting, serpentine);
+    while (std::next_permutation(nesting.begin(), nesting.end())) {
+        GridOrder candidate = gridOrderCost(axes, nesting, serpentine);
+        if (candidate.cost < best.cost) best = candidate;
+    }
+    return best;
+}
+
+void calibrateAxisCosts(std::vector<SweepAxis>& axes, const std::function<void()>& probe) {
+    using Clock = std::chrono::steady_clock;
+    auto timed = [](const std::function<void()>& fn) {
+        auto t0 = Clock::now();
+        fn();
+        return std::chrono::duration<double>(Clock::now() - t0).count();
+    };
+
+    // The first reading absorbs the initial setup; the second is the baseline
+    for (auto& axis : axes)
+        if (axis.apply && !axis.values.empty()) axis.apply(axis.values[0]);
+    probe();
+    double base = timed(probe);
+
+    for (auto& axis : axes) {
+        if (!axis.apply || axis.values.size() < 2) continue;
+        double t = timed([&] {
+            axis.apply(axis.values[1]);
+            probe();
+        });
+        axis.changeCost = std::max(0.0, t - base);
+        axis.apply(axis.values[0]);
+    }
+}
+
+// Mixed-radix counter over the nesting; in serpentine order a loop runs
+// backwards whenever the combined count of its outer loops is odd
+void runGrid(const std::vector<SweepAxis>& axes, const GridOrder& order, const GridPointCallback& onPoint) {
+    if (order.nesting.size() != axes.size()) throw std::invalid_argument("Grid order does not match the axes");
+    std::size_t total = 1;
+    for (const auto& axis : axes) total *= axis.values.size();
+    if (total == 0) return;
+
+    const std::size_t none = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> index(axes.size(), 0);
+    std::vector<std::size_t> applied(axes.size(), none);
+
+    for (std::size_t step = 0; step < total; ++step) {
+        std::size_t inner = total;  // Points covered by one pass of the current loop
+        for (std::size_t axis : order.nesting) {
+            std::size_t n = axes[axis].values.size();
+            std::size_t outerCount = step / inner;
+            inner /= n;
+            std::size_t pos = (step / inner) % n;
+            if (order.serpentine && (outerCount & 1)) pos = n - 1 - pos;
+            index[axis] = pos;
+        }
+
+        // Outer axes first, so an inner axis is applied in its final context
+        for (std::size_t axis : order.nesting) {
+            if (applied[axis] == index[axis]) continue;
+            if (axes[axis].apply) axes[axis].apply(axes[axis].values[index[axis]]);
+            applied[axis] = index[axis];
+        }
+        onPoint(index);
+    }
+}
+
+std::vector<double> parseAxisValues(const std::string& spec, bool logSpaced) {
+    std::vector<double> values;
+    if (spec.find(':') != std::string::npos) {
+        std::stringstream ss(spec);
+        std::string a, b, n;
+        if (!std::getline(ss, a, ':') || !std::getline(ss, b, ':') || !std::getline(ss, n))
+            throw std::invalid_argument("Axis range must be start:end:points");
+        double start = std::stod(a), end = std::stod(b);
+        int points = std::stoi(n);
+        if (points <= 0) throw std::invalid_argument("Axis range needs at least one point");
+        bool log = logSpaced && start > 0 && end > 0;
+        for (int i = 0; i < points; ++i) {
+            double t = points == 1 ? 0.0 : static_cast<double>(i) / (points - 1);
+            values.push_back(log ? start * std::pow(end / start, t) : start + t * (end - start));
+        }
+        return values;
+    }
+
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) values.push_back(std::stod(item));
+    if (values.empty()) throw std::invalid_argument("Axis has no values");
+    return values;
+}
+
+// Frequency and range changes dominate on LCR meters, bias changes cost a settle;
+// the planner nests the axes so the expensive ones change least often
+GridOrder runCapacitanceSweep(MeasurementManager& meas, const CapacitancePlan& plan, DataManager& data,
+                              const std::function<void(const CapacitancePoint&)>& onPoint) {
+    // An LCR meter has no :MEAS:VOLT?/:MEAS:CURR?, so converging polls Cp instead (1 fF floor)
+    SettleConfig settle = plan.settle;
+    if (settle.convergeQuery.empty()) {
+        settle.convergeQuery = ":FETC:IMP?";
+        settle.absTolerance = 1e-15;
+    }
+    SettlingEngine settler(settle);
+    std::vector<SweepAxis> axes(3);
+    axes[0] = {"bias", plan.bias, plan.settle.fixedDelay, [&](double v) {
+                   ScopedTimer t("grid.bias");
+                   meas.sendBatch({":BIAS:VOLT " + formatReal(v), ":BIAS:STAT ON"});
+                   settler.settle(meas, v);
+               }};
+    axes[1] = {"frequency", plan.frequencies, plan.frequencyCost, [&](double f) {
+                   ScopedTimer t("grid.frequency");
+                   meas.sendBatch({":FREQ " + formatReal(f)});
+               }};
+    axes[2] = {"ac_level", plan.acLevels, plan.acLevelCost, [&](double level) {
+                   ScopedTimer t("grid.ac_level");
+                   meas.sendBatch({":VOLT " + formatReal(level)});
+               }};
+
+    GridData& grid = data.beginGrid({"bias", "frequency", "ac_level"}, {plan.bias, plan.frequencies, plan.acLevels},
+                                    {"Cp", "D"});
+    meas.sendBatch({":FUNC:IMP CPD"});
+    std::vector<double> reading(3);
+    if (plan.calibrate) {
+        ScopedTimer t("grid.calibrate");
+        calibrateAxisCosts(axes, [&] { meas.queryReals(":FETC:IMP?", reading); });
+    }
+
+    GridOrder order = planGridOrder(axes);
+    profileCount("grid.changes", static_cast<std::int64_t>(order.changes));
+
+    runGrid(axes, order, [&](std::span<const std::size_t> index) {
+        ScopedTimer t("grid.measure");
+        // Cp, D and the measurement status
+        if (meas.queryReals(":FETC:IMP?", reading) < 2) throw std::runtime_error("Incomplete impedance reading");
+        double cd[2] = {reading[0], reading[1]};
+        grid.set(index, cd);
+        if (onPoint)
+            onPoint({{index[0], index[1], index[2]}, plan.bias[index[0]], plan.frequencies[index[1]],
+                     plan.acLevels[index[2]], reading[0], reading[1]});
+    });
+
+    if (plan.settle.mode == SettleMode::Table && !plan.settle.tablePath.empty())
+        settler.saveTable(plan.settle.tablePath);
+    return order;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+#include "data_manager.hpp"
+#include "measurement_manager.hpp"
+#include "settling.hpp"
+
+// One swept parameter of a multi-dimensional sweep
+struct SweepAxis {
+    std::string name;
+    std::vector<double> values;
+    double changeCost = 0.0;              // Estimated seconds to apply a new value (reconfigure, settle)
+    std::function<void(double)> apply;    // Program the instrument to this value
+};
+
+// Traversal of a grid: which axis is stepped in which loop
+struct GridOrder {
+    std::vector<std::size_t> nesting;     // Axis indices, outermost loop first
+    bool serpentine = true;               // Inner loops reverse direction on every outer step
+    std::size_t changes = 0;              // Axis value changes over the whole run
+    double cost = 0.0;                    // Estimated reconfiguration time (s)
+};
+
+// Changes and estimated cost of walking the grid with the given nesting.
+// Serpentine order never jumps an inner axis back to its start, so an inner
+// axis changes (n - 1) times per outer step instead of n.
+GridOrder gridOrderCost(const std::vector<SweepAxis>& axes, const std::vector<std::size_t>& nesting,
+                        bool serpentine);
+
+// Cheapest nesting over all permutations of the axes (grids have a handful of them)
+GridOrder planGridOrder(const std::vector<SweepAxis>& axes, bool serpentine = true);
+
+// Replace each axis' estimated cost by a measured one: the time to apply its
+// second value and take a reading (probe), minus the time of a reading alone.
+// Leaves every axis at its first value.
+void calibrateAxisCosts(std::vector<SweepAxis>& axes, const std::function<void()>& probe);
+
+// Called at every grid point once all axes hold their values; index is in axis order
+using GridPointCallback = std::function<void(std::span<const std::size_t> index)>;
+
+// Walk the grid in the given order. An axis is only re-applied when its value
+// changes, so settled instrument state is reused across points.
+void runGrid(const std::vector<SweepAxis>& axes, const GridOrder& order, const GridPointCallback& onPoint);
+
+// Axis values from "v", "v1,v2,..." or "start:end:n" (n points, log spaced if requested)
+std::vector<double> parseAxisValues(const std::string& spec, bool logSpaced = false);
+
+// C-V / C-f characterization on an LCR meter: bias x frequency x AC level
+struct CapacitancePlan {
+    std::vector<double> bias;             // DC bias voltages (V)
+    std::vector<double> frequencies;      // Test signal frequencies (Hz)
+    std::vector<double> acLevels;         // Test signal amplitudes (V rms)
+    SettleConfig settle;                  // Applied after every bias change
+
+    // Typical reconfiguration times used to choose the order (s); the bias
+    // estimate is the settle delay. Replaced by measured times when calibrating.
+    double frequencyCost = 0.05;          // Oscillator re-lock and range search
+    double acLevelCost = 0.005;
+    bool calibrate = true;                // Time one change per axis before the run
+};
+
+// Measured values of one grid point
+struct CapacitancePoint {
+    std::array<std::size_t, 3> index;   // Bias, frequency, AC level
+    double bias;
+    double frequency;
+    double acLevel;
+    double cp;   // Parallel capacitance (F)
+    double d;    // Dissipation factor
+};
+
+// Measure Cp and D over the whole plan into data.grid() (axes bias, frequency,
+// ac_level; channels Cp, D) using the cheapest traversal; returns that traversal
+GridOrder runCapacitanceSweep(MeasurementManager& meas, const CapacitancePlan& plan, DataManager& data,
+                              const std::function<void(const CapacitancePoint&)>& onPoint = nullptr);
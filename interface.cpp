@@ -3,27 +3,33 @@
 #include <iostream>
 #include <regex>
 
-// Constructor defines available parameter fields for each measurement type
-Interface::Interface() {
-    parameters["Resistance"] = {
-        "Vstart",
-        "Vend",
-        "Points number",
-        "Plot (y/n)",
-        "Save data table (y/n)"
-    };
-
-    parameters["Capacitance"] = {
-        "Vstart",
-        "Vend",
-        "Frequency",
-        "AC level",
-        "Points number",
-        "Plot (y/n)",
-        "Save data table (y/n)"
-    };
+// Available parameter fields for each measurement type
+const std::map<std::string, std::vector<std::string>>& measurementFields() {
+    static const std::map<std::string, std::vector<std::string>> fields = {
+        {"Resistance",
+         {"Vstart",
+          "Vend",
+          "Points number",
+          "Sampling (uniform/adaptive)",
+          "Averaging (max readings)",
+          "Settling (fixed/opc/auto/table)",
+          "Plot (y/n)",
+          "Save data table (y/n)"}},
+        {"Capacitance",
+         {"Vstart",
+          "Vend",
+          "Frequency",
+          "AC level",
+          "Points number",
+          "Settling (fixed/opc/auto/table)",
+          "Plot (y/n)",
+          "Save data table (y/n)"}}};
+    return fields;
 }
 
+// Constructor defines available parameter fields for each measurement type
+Interface::Interface() : parameters(measurementFields()) {}
+
 Interface::~Interface() {}
 
 // Display ncurses-based selection menu
@@ -61,14 +67,43 @@ void Interface::Run() {
     parameterEditor(types[choice]);
 }
 
-// Validate field input format (float, integer, yes/no)
+// Ask one question outside of the parameter flow (e.g. whether to resume a run)
+int Interface::choose(const std::vector<std::string>& items, const std::string& title) {
+    initscr();
+    noecho();
+    cbreak();
+    keypad(stdscr, TRUE);
+    int choice = menu(items, title);
+    endwin();
+    return choice;
+}
+
+// Validate field input format (float, integer, yes/no); patterns are compiled on first use only
 bool validateInput(const std::string& field, const std::string& value) {
-    if (field == "Vstart" || field == "Vend" || field == "Frequency" || field == "AC level") {
-        return std::regex_match(value, std::regex(R"(^-?\d+(\.\d+)?$)"));
+    static const std::string num = R"(\d+(\.\d+)?([eE][+-]?\d+)?)";
+    static const std::regex voltage(R"(^-?\d+(\.\d+)?$)");
+    // One value, a list "v1,v2,..." or a range "start:end:points" (swept as a grid axis)
+    static const std::regex axis("^(" + num + "(," + num + ")*|" + num + ":" + num + R"(:\d+)$)");
+    static const std::regex count(R"(^\d+$)");
+    static const std::regex optionalCount(R"(^\d*$)");
+    static const std::regex sampling(R"(^(|uniform|adaptive)$)");
+    static const std::regex settling(R"(^(|fixed|opc|auto|table)$)");
+    static const std::regex yesNo(R"(^(y|n|Y|N)$)");
+
+    if (field == "Vstart" || field == "Vend") {
+        return std::regex_match(value, voltage);
+    } else if (field == "Frequency" || field == "AC level") {
+        return std::regex_match(value, axis);
     } else if (field == "Points number") {
-        return std::regex_match(value, std::regex(R"(^\d+$)"));
+        return std::regex_match(value, count);
+    } else if (field == "Averaging (max readings)") {
+        return std::regex_match(value, optionalCount);
+    } else if (field == "Sampling (uniform/adaptive)") {
+        return std::regex_match(value, sampling);
+    } else if (field == "Settling (fixed/opc/auto/table)") {
+        return std::regex_match(value, settling);
     } else if (field == "Plot (y/n)" || field == "Save data table (y/n)") {
-        return std::regex_match(value, std::regex(R"(^(y|n|Y|N)$)"));
+        return std::regex_match(value, yesNo);
     }
     return true;
 }
@@ -3,6 +3,12 @@
 #include <vector>
 #include <map>
 
+// Parameter fields of each measurement type, in editor order
+const std::map<std::string, std::vector<std::string>>& measurementFields();
+
+// Check one field value (numbers, lists, ranges, y/n, ...); shared by the editor and job files
+bool validateInput(const std::string& field, const std::string& value);
+
 // Interface class handles user interaction using ncurses-based menu and parameter editing
 class Interface {
 public:
@@ -10,6 +16,9 @@ public:
     ~Interface();  // Destructor (nothing to clean up)
 
     void Run();
+
+    // Standalone menu (sets up and ends ncurses itself), returns the chosen index
+    int choose(const std::vector<std::string>& items, const std::string& title);
     // Returns selected measurement type and its configured parameters
     std::pair<std::string, std::map<std::string, std::string>> getMeasurementParams() const;
 
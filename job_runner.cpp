@@ -0,0 +1,465 @@
+#include "job_runner.hpp"
+#include "interface.hpp"
+#include "orchestrator.hpp"
+#include "csv_writer.hpp"
+#include "plot_renderer.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+static std::string trim(const std::string& s) {
+    std::size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return "";
+    std::size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+static std::string homeDir(const std::string& sub) {
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + sub;
+}
+
+// "~/x" relative to HOME
+static std::string expandHome(const std::string& path) {
+    if (path.rfind("~/", 0) == 0) return homeDir(path.substr(1));
+    return path;
+}
+
+// Interface field named by a job file key: the full name or the part before " ("
+static std::string fieldForKey(const std::vector<std::string>& fields, const std::string& key) {
+    for (const auto& field : fields) {
+        if (field == key || field.substr(0, field.find(" (")) == key) return field;
+    }
+    return "";
+}
+
+// Check a finished job block and fill in defaults
+static void finishJob(Job& job, const std::string& path) {
+    auto where = [&] { return path + ":" + std::to_string(job.line) + ": job '" + job.name + "'"; };
+    const auto& types = measurementFields();
+    auto type = types.find(job.type);
+    if (type == types.end()) throw std::runtime_error(where() + ": unknown type " + job.type);
+
+    std::vector<std::string> required = {"Vstart", "Vend", "Points number"};
+    if (job.type == "Capacitance") {
+        required.push_back("Frequency");
+        required.push_back("AC level");
+    }
+    for (const auto& field : required) {
+        if (!job.params.count(field)) throw std::runtime_error(where() + ": missing " + field);
+    }
+    for (const auto& [field, value] : job.params) {
+        if (std::find(type->second.begin(), type->second.end(), field) == type->second.end())
+            throw std::runtime_error(where() + ": " + field + " does not apply to " + job.type);
+    }
+    for (const auto& field : type->second) {
+        if (job.params.count(field)) continue;
+        if (field == "Plot (y/n)") job.params[field] = "n";
+        else if (field == "Save data table (y/n)") job.params[field] = "y";
+        else job.params[field] = "";
+    }
+
+    if (job.output.empty()) {
+        job.output = job.name;
+        std::replace_if(job.output.begin(), job.output.end(), [](char c) { return c == ' ' || c == '/'; }, '_');
+    }
+    if (job.dataDir.empty()) job.dataDir = homeDir("/Desktop/data");
+    if (job.plotDir.empty()) job.plotDir = homeDir("/Desktop/plots");
+}
+
+std::vector<Job> parseJobFile(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Failed to open job file " + path);
+
+    const auto& types = measurementFields();
+    std::vector<std::string> allFields;
+    for (const auto& [type, fields] : types) allFields.insert(allFields.end(), fields.begin(), fields.end());
+
+    std::vector<Job> jobs;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo) {
+        auto where = [&] { return path + ":" + std::to_string(lineNo) + ": "; };
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+
+        if (line.front() == '[') {
+            if (line.back() != ']') throw std::runtime_error(where() + "expected [job name]");
+            if (!jobs.empty()) finishJob(jobs.back(), path);
+            jobs.push_back({});
+            jobs.back().name = trim(line.substr(1, line.size() - 2));
+            jobs.back().line = lineNo;
+            if (jobs.back().name.empty()) jobs.back().name = "job" + std::to_string(jobs.size());
+            continue;
+        }
+
+        std::size_t eq = line.find('=');
+        if (eq == std::string::npos) throw std::runtime_error(where() + "expected key = value");
+        if (jobs.empty()) throw std::runtime_error(where() + "setting outside of a [job]");
+        Job& job = jobs.back();
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+
+        if (key == "type") {
+            job.type = value;
+        } else if (key == "endpoint") {
+            std::size_t colon = value.rfind(':');
+            job.host = value.substr(0, colon);
+            if (colon != std::string::npos) {
+                std::string port = value.substr(colon + 1);
+                if (port.empty() || port.find_first_not_of("0123456789") != std::string::npos)
+                    throw std::runtime_error(where() + "invalid port in " + value);
+                job.port = std::stoi(port);
+            }
+            if (job.host.empty()) throw std::runtime_error(where() + "missing host in " + value);
+        } else if (key == "output") {
+            if (value.empty() || value.find('/') != std::string::npos)
+                throw std::runtime_error(where() + "output must be a plain file name base");
+            job.output = value;
+        } else if (key == "data dir") {
+            job.dataDir = expandHome(value);
+        } else if (key == "plot dir") {
+            job.plotDir = expandHome(value);
+        } else {
+            std::string field = fieldForKey(allFields, key);
+            if (field.empty()) throw std::runtime_error(where() + "unknown key " + key);
+            if (!validateInput(field, value)) throw std::runtime_error(where() + "invalid value for " + field + ": " + value);
+            job.params[field] = value;
+        }
+    }
+    if (!jobs.empty()) finishJob(jobs.back(), path);
+    return jobs;
+}
+
+static std::string param(const std::map<std::string, std::string>& params, const std::string& field) {
+    auto it = params.find(field);
+    return it == params.end() ? "" : it->second;
+}
+
+static bool yes(const std::string& value) {
+    return value == "y" || value == "Y";
+}
+
+SweepPlan sweepPlanFromParams(const std::map<std::string, std::string>& params) {
+    SweepPlan plan;
+    plan.vstart = std::stod(param(params, "Vstart"));
+    plan.vend = std::stod(param(params, "Vend"));
+    plan.points = std::stoi(param(params, "Points number"));
+    plan.settle.mode = parseSettleMode(param(params, "Settling (fixed/opc/auto/table)"));
+    plan.settle.tablePath = homeDir("/.local/share/keysight/settle_table.txt");
+    plan.adaptive = (param(params, "Sampling (uniform/adaptive)") == "adaptive");  // Points number is then the budget
+
+    // Up to N readings per point, fewer once the mean is known to 0.1 % (95 % confidence)
+    std::string maxReadings = param(params, "Averaging (max readings)");
+    if (!maxReadings.empty() && std::stoi(maxReadings) > 1) {
+        plan.average = true;
+        plan.averaging.maxSamples = std::stoi(maxReadings);
+        plan.averaging.targetRelative = 1e-3;
+        plan.averaging.instrumentAveraging = true;
+    }
+    return plan;
+}
+
+CapacitancePlan capacitancePlanFromParams(const std::map<std::string, std::string>& params, const SweepPlan& plan) {
+    CapacitancePlan cplan;
+    cplan.bias = plan.voltages();
+    cplan.frequencies = parseAxisValues(param(params, "Frequency"), true);
+    cplan.acLevels = parseAxisValues(param(params, "AC level"));
+    cplan.settle = plan.settle;
+    return cplan;
+}
+
+RunMetadata runMetadata(const std::string& type, const std::map<std::string, std::string>& params,
+                        const SweepPlan& plan, const std::string& csvPath, const ScpiLinkStats& link) {
+    return {{"measurement", type},
+            {"vstart", param(params, "Vstart")},
+            {"vend", param(params, "Vend")},
+            {"points", param(params, "Points number")},
+            {"sampling", plan.adaptive ? "adaptive" : "uniform"},
+            {"averaging", param(params, "Averaging (max readings)")},
+            {"settling", param(params, "Settling (fixed/opc/auto/table)")},
+            {"csv", csvPath},
+            {"link_timeouts", std::to_string(link.timeouts)},
+            {"link_resets", std::to_string(link.resets + link.shortReplies)},
+            {"link_garbled", std::to_string(link.garbled)},
+            {"link_retries", std::to_string(link.retries)}};
+}
+
+ScpiLinkStats linkStatsSince(const ScpiLinkStats& before, const ScpiLinkStats& now) {
+    return {now.connects - before.connects,         now.connectFailures - before.connectFailures,
+            now.timeouts - before.timeouts,         now.resets - before.resets,
+            now.shortReplies - before.shortReplies, now.garbled - before.garbled,
+            now.retries - before.retries};
+}
+
+void renderRunPlot(const std::string& path, const DataManager& data, bool capacitance) {
+    ScopedTimer t("plot.render");
+    if (!capacitance) {
+        PlotOptions opt;
+        opt.title = "I-V Sweep";
+        renderPlotPng(path, {{"", data.voltages(), data.currents()}}, opt);
+        return;
+    }
+
+    const GridData& grid = data.grid();
+    std::vector<std::vector<double>> cp;
+    std::vector<PlotSeries> series;
+    for (std::size_t f = 0; f < grid.shape()[1]; ++f) {
+        std::size_t at[3] = {0, f, 0};
+        cp.push_back(grid.line(at, 0, 0));
+    }
+    for (std::size_t f = 0; f < cp.size(); ++f) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%g Hz", grid.axisValues(1)[f]);
+        series.push_back({name, grid.axisValues(0), cp[f]});
+    }
+    PlotOptions opt;
+    opt.title = "C-V Sweep";
+    opt.yLabel = "Cp (F)";
+    renderPlotPng(path, series, opt);
+}
+
+JobRunner::JobRunner(std::size_t maxPending, bool concurrent)
+    : maxPending_(std::max<std::size_t>(maxPending, 1)), concurrent_(concurrent) {}
+
+JobRunner::~JobRunner() = default;
+
+std::size_t JobRunner::connections() const {
+    return connections_.size();
+}
+
+static std::string endpointOf(const Job& job) {
+    return job.host + ":" + std::to_string(job.port);
+}
+
+MeasurementManager& JobRunner::connect(const Job& job) {
+    std::string endpoint = endpointOf(job);
+    auto it = connections_.find(endpoint);
+    if (it == connections_.end()) {
+        ScopedTimer t("batch.connect");
+        it = connections_.emplace(endpoint, std::make_unique<MeasurementManager>(Machine(job.host, job.port))).first;
+    } else {
+        profileCount("batch.connection_reused");
+    }
+    return *it->second;
+}
+
+// Samples go straight into the job's own DataManager; nothing else runs on
+// this thread, the previous job's export proceeds in the background
+void JobRunner::acquire(const Job& job, MeasurementManager& meas, const SweepPlan& plan, DataManager& data) {
+    ScopedTimer t("batch.acquire");
+    std::string idn = meas.identify();
+    if (job.type == "Capacitance") {
+        runCapacitanceSweep(meas, capacitancePlanFromParams(job.params, plan), data);
+        return;
+    }
+    data.reserve(plan.points);
+    runSweep(meas, plan, [&](const SweepPoint& p) {
+        data.addMeasurement(idn, p.voltage, p.current, p.settleTime, p.setVoltage);
+    });
+}
+
+void JobRunner::exportJob(ExportTask& task) {
+    ScopedTimer t("batch.export");
+    const Job& job = *task.job;
+    JobResult& result = *task.result;
+    bool capacitance = (job.type == "Capacitance");
+
+    if (!task.dataFile.empty()) {
+        std::filesystem::remove(task.dataFile);
+        if (capacitance) {
+            task.data->grid().saveCSV(task.dataFile);
+        } else {
+            CsvFlushPolicy policy;
+            policy.bufferBytes = 1 << 20;
+            policy.everySeconds = 0;
+            CsvStreamWriter out(task.dataFile, policy, FsyncPolicy::OnClose);
+            for (std::size_t i = 0; i < task.data->size(); ++i) out.appendRow(*task.data, i);
+            out.close();
+        }
+        result.files.push_back(task.dataFile);
+
+        if (!capacitance) {
+            std::string runFile = task.dataFile.substr(0, task.dataFile.size() - 4) + ".run";
+            writeRunFile(runFile, *task.data,
+                         runMetadata(job.type, job.params, task.plan, task.dataFile, result.link));
+            result.files.push_back(runFile);
+        }
+    }
+    if (!task.plotFile.empty()) {
+        renderRunPlot(task.plotFile, *task.data, capacitance);
+        result.files.push_back(task.plotFile);
+    }
+}
+
+void JobRunner::exportLoop(const std::function<void(const JobResult&)>& onDone) {
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return closing_ || !pending_.empty(); });
+        if (pending_.empty()) return;
+        ExportTask task = std::move(pending_.front());
+        pending_.pop_front();
+        lock.unlock();
+        cv_.notify_all();
+
+        // Failed acquisitions pass through too, so onDone sees every job in order
+        if (task.result->error.empty()) {
+            auto t0 = std::chrono::steady_clock::now();
+            try {
+                exportJob(task);
+                task.result->ok = true;
+            } catch (const std::exception& e) {
+                task.result->error = std::string("export: ") + e.what();
+            }
+            task.result->exportSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+        if (onDone) onDone(*task.result);
+    }
+}
+
+// Output paths are claimed (created empty) on the scheduler thread, so a later
+// job with the same name base never picks a path whose export is still queued
+static std::string claimPath(const std::string& dir, const std::string& base, const std::string& ext) {
+    std::filesystem::create_directories(dir);
+    std::string path = uniqueRunPath(dir, base, ext);
+    std::ofstream touch(path);
+    if (!touch) throw std::runtime_error("Failed to create " + path);
+    return path;
+}
+
+// Point count, and output paths claimed only for jobs that measured
+void JobRunner::measured(const Job& job, ExportTask& task) {
+    JobResult& result = *task.result;
+    result.points = job.type == "Capacitance" ? task.data->grid().filled() : task.data->size();
+    if (yes(param(job.params, "Save data table (y/n)")))
+        task.dataFile = claimPath(job.dataDir, job.output, "csv");
+    if (yes(param(job.params, "Plot (y/n)"))) task.plotFile = claimPath(job.plotDir, job.output, "png");
+}
+
+// Go on measuring while the exporter works; wait only when it is maxPending jobs behind
+void JobRunner::enqueue(ExportTask task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return pending_.size() < maxPending_; });
+    pending_.push_back(std::move(task));
+    lock.unlock();
+    cv_.notify_all();
+}
+
+// Round r holds the r-th job of every endpoint. Its sweeps run at the same time,
+// each on its endpoint's pooled connection, so a round takes as long as its
+// slowest instrument; the round is exported in file order once all are measured.
+void JobRunner::runRounds(const std::vector<Job>& jobs, std::vector<JobResult>& results) {
+    std::vector<std::vector<std::size_t>> rounds;
+    std::map<std::string, std::size_t> seen;
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        std::size_t r = seen[endpointOf(jobs[i])]++;
+        if (r == rounds.size()) rounds.emplace_back();
+        rounds[r].push_back(i);
+    }
+
+    for (const auto& round : rounds) {
+        ScopedTimer t("batch.round");
+        std::vector<ExportTask> tasks;
+        std::vector<ScpiLinkStats> before(round.size());
+        std::vector<std::size_t> queued;   // Task of each Orchestrator job
+        Orchestrator orchestrator;
+        for (std::size_t k = 0; k < round.size(); ++k) {
+            const Job& job = jobs[round[k]];
+            JobResult& result = results[round[k]];
+            result.name = job.name;
+            tasks.push_back({&job, &result, {}, std::make_unique<DataManager>(), "", ""});
+            try {
+                SweepPlan& plan = tasks.back().plan;
+                plan = sweepPlanFromParams(job.params);
+                InstrumentJob ij{job.name, Machine(job.host, job.port), plan};
+                if (job.type == "Capacitance") ij.grid = capacitancePlanFromParams(job.params, plan);
+                ij.session = &connect(job);
+                before[k] = ij.session->linkStats();
+                orchestrator.add(std::move(ij));
+                queued.push_back(k);
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+        }
+
+        std::vector<InstrumentRun> runs = orchestrator.run();
+        for (std::size_t q = 0; q < queued.size(); ++q) {
+            ExportTask& task = tasks[queued[q]];
+            const Job& job = *task.job;
+            JobResult& result = *task.result;
+            InstrumentRun& run = runs[q];
+            result.link = linkStatsSince(before[queued[q]], connections_.at(endpointOf(job))->linkStats());
+            result.acquireSeconds = run.seconds;
+            if (!run.ok) {
+                result.error = run.error;
+                connections_.erase(endpointOf(job));
+                continue;
+            }
+            task.data = std::make_unique<DataManager>(std::move(run.data));
+            try {
+                measured(job, task);
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+        }
+        for (auto& task : tasks) enqueue(std::move(task));
+    }
+}
+
+std::vector<JobResult> JobRunner::run(const std::vector<Job>& jobs,
+                                      const std::function<void(const JobResult&)>& onDone) {
+    std::vector<JobResult> results(jobs.size());
+    closing_ = false;
+    std::thread exporter([&] { exportLoop(onDone); });
+
+    if (concurrent_) {
+        runRounds(jobs, results);
+    } else {
+        runInOrder(jobs, results);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    cv_.notify_all();
+    exporter.join();
+    return results;
+}
+
+// One job at a time on this thread
+void JobRunner::runInOrder(const std::vector<Job>& jobs, std::vector<JobResult>& results) {
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        const Job& job = jobs[i];
+        JobResult& result = results[i];
+        result.name = job.name;
+
+        ExportTask task{&job, &result, {}, std::make_unique<DataManager>(), "", ""};
+        auto t0 = std::chrono::steady_clock::now();
+        try {
+            task.plan = sweepPlanFromParams(job.params);
+            MeasurementManager& meas = connect(job);
+            ScpiLinkStats before = meas.linkStats();
+            try {
+                acquire(job, meas, task.plan, *task.data);
+            } catch (...) {
+                // Reconnect on the next job for this endpoint rather than reuse a session
+                // the failure may have left mid-sweep; plan and file errors keep it
+                result.link = linkStatsSince(before, meas.linkStats());
+                connections_.erase(endpointOf(job));
+                throw;
+            }
+            result.link = linkStatsSince(before, meas.linkStats());
+            measured(job, task);
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        result.acquireSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        enqueue(std::move(task));
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "measurement_manager.hpp"
+#include "data_manager.hpp"
+#include "sweep.hpp"
+#include "grid_sweep.hpp"
+#include "run_file.hpp"
+
+// One sweep of a job file: what to measure, where, and how to name the output
+struct Job {
+    std::string name;
+    std::string type = "Resistance";                 // A measurementFields() type
+    std::map<std::string, std::string> params;       // Interface field -> value
+    std::string host = "127.0.0.1";
+    int port = 5025;
+    std::string output;                              // File name base (default: job name)
+    std::string dataDir;                             // Default ~/Desktop/data
+    std::string plotDir;                             // Default ~/Desktop/plots
+    int line = 0;                                    // Where the job starts in its file
+};
+
+// Read a job file: "[name]" starts a job, followed by "key = value" lines.
+// Keys are type, endpoint (host[:port]), output, data dir, plot dir and the
+// interface fields, either in full ("Plot (y/n)") or without the hint ("Plot").
+// Values are checked with validateInput; errors name the file and line.
+std::vector<Job> parseJobFile(const std::string& path);
+
+// Sweep parameters from interface fields (shared by the editor and job files)
+SweepPlan sweepPlanFromParams(const std::map<std::string, std::string>& params);
+CapacitancePlan capacitancePlanFromParams(const std::map<std::string, std::string>& params, const SweepPlan& plan);
+
+// Sweep parameters and instrument link faults stored in a run file
+RunMetadata runMetadata(const std::string& type, const std::map<std::string, std::string>& params,
+                        const SweepPlan& plan, const std::string& csvPath, const ScpiLinkStats& link = {});
+
+// Link faults and retries between two snapshots of a session's counters
+ScpiLinkStats linkStatsSince(const ScpiLinkStats& before, const ScpiLinkStats& now);
+
+// Render the I-V curve, or C-V per frequency at the first AC level, to PNG
+void renderRunPlot(const std::string& path, const DataManager& data, bool capacitance);
+
+// Outcome of one job
+struct JobResult {
+    std::string name;
+    bool ok = false;
+    std::string error;                   // Set when ok is false
+    std::size_t points = 0;              // Stored samples or grid cells
+    double acquireSeconds = 0.0;
+    double exportSeconds = 0.0;
+    ScpiLinkStats link;                  // Timeouts, resets and retries during acquisition
+    std::vector<std::string> files;      // Written outputs
+};
+
+// Runs jobs back to back on one scheduler thread. Instrument connections are
+// kept per endpoint across jobs (and across run() calls), so the socket, the
+// cached IDN and the list / averaging capability probes are paid once. Export
+// and plotting of a finished job run on a background thread while the next
+// job acquires. With concurrent set, jobs on different endpoints acquire at
+// the same time on an Orchestrator: the first job of every endpoint, then the
+// second, and so on; jobs on one endpoint still run in file order.
+class JobRunner {
+public:
+    // maxPending: finished jobs allowed to wait for export before acquisition blocks
+    explicit JobRunner(std::size_t maxPending = 2, bool concurrent = false);
+    ~JobRunner();
+
+    // Run all jobs and wait for their exports; onDone is called from the export
+    // thread as each job completes (in file order, or round by round when
+    // concurrent). A failed job does not stop the rest.
+    std::vector<JobResult> run(const std::vector<Job>& jobs,
+                               const std::function<void(const JobResult&)>& onDone = {});
+
+    // Open instrument connections
+    std::size_t connections() const;
+
+private:
+    // A measured job waiting for export
+    struct ExportTask {
+        const Job* job;
+        JobResult* result;
+        SweepPlan plan;
+        std::unique_ptr<DataManager> data;
+        std::string dataFile;
+        std::string plotFile;
+    };
+
+    // Connection for the job's endpoint, opened on first use
+    MeasurementManager& connect(const Job& job);
+
+    // Measure one job into data
+    void acquire(const Job& job, MeasurementManager& meas, const SweepPlan& plan, DataManager& data);
+
+    // Jobs measured one at a time on the scheduler thread
+    void runInOrder(const std::vector<Job>& jobs, std::vector<JobResult>& results);
+
+    // Jobs of each round measured at the same time on an Orchestrator
+    void runRounds(const std::vector<Job>& jobs, std::vector<JobResult>& results);
+
+    // Point count and claimed output paths of a measured job
+    void measured(const Job& job, ExportTask& task);
+
+    // Hand a job to the exporter; blocks while maxPending jobs are waiting
+    void enqueue(ExportTask task);
+
+    // Write CSV, run file and plot of one job
+    void exportJob(ExportTask& task);
+
+    void exportLoop(const std::function<void(const JobResult&)>& onDone);
+
+    std::size_t maxPending_;
+    bool concurrent_;
+    std::map<std::string, std::unique_ptr<MeasurementManager>> connections_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<ExportTask> pending_;
+    bool closing_ = false;
+};
@@ -0,0 +1,298 @@
+#include "journal.hpp"
+#include "checksum.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char kJournalMagic[8] = {'C', 'D', 'A', 'J', 'R', 'N', 'L', '\0'};
+
+static std::int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::uint32_t recordCrc(const JournalRecord& r) {
+    return crc32(reinterpret_cast<const std::uint8_t*>(&r), offsetof(JournalRecord, crc));
+}
+
+std::string JournalContents::value(const std::string& key) const {
+    for (const auto& [k, v] : metadata)
+        if (k == key) return v;
+    return "";
+}
+
+JournalContents readJournal(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("Failed to open journal " + path);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    JournalHeader header;
+    if (bytes.size() < sizeof(header)) throw std::runtime_error("Journal too short: " + path);
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, kJournalMagic, sizeof(kJournalMagic)) != 0)
+        throw std::runtime_error("Not a journal: " + path);
+    if (header.version != kJournalVersion)
+        throw std::runtime_error("Unsupported journal version " + std::to_string(header.version));
+
+    std::size_t offset = sizeof(header);
+    if (bytes.size() < offset + header.metadataSize + sizeof(std::uint32_t))
+        throw std::runtime_error("Journal metadata truncated: " + path);
+    std::uint32_t crc;
+    std::memcpy(&crc, bytes.data() + offset + header.metadataSize, sizeof(crc));
+    if (crc != crc32(reinterpret_cast<const std::uint8_t*>(bytes.data() + offset), header.metadataSize))
+        throw std::runtime_error("Journal metadata corrupt: " + path);
+
+    JournalContents contents;
+    std::string text = bytes.substr(offset, header.metadataSize);
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string line = text.substr(pos, end - pos);
+        std::size_t eq = line.find('=');
+        if (eq != std::string::npos) contents.metadata.emplace_back(line.substr(0, eq), line.substr(eq + 1));
+        pos = end + 1;
+    }
+    offset += header.metadataSize + sizeof(crc);
+    contents.validBytes = offset;
+
+    // Records up to the first one that is incomplete or fails its CRC
+    JournalRecord r;
+    while (!contents.finished && offset + sizeof(r) <= bytes.size()) {
+        std::memcpy(&r, bytes.data() + offset, sizeof(r));
+        if (r.crc != recordCrc(r)) break;
+        if (r.tag == JournalTag::Point) {
+            contents.points.push_back(
+                {{r.index, r.setVoltage, r.voltage, r.current, r.settleTime}, r.monotonicNs, r.wallNs});
+        } else if (r.tag == JournalTag::End) {
+            contents.finished = true;
+        } else {
+            break;
+        }
+        offset += sizeof(r);
+        contents.validBytes = offset;
+    }
+    return contents;
+}
+
+std::vector<std::string> findUnfinishedJournals(const std::string& dir) {
+    std::vector<std::pair<std::filesystem::file_time_type, std::string>> found;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (!entry.is_regular_file() || entry.path().extension() != ".journal") continue;
+        try {
+            if (!readJournal(entry.path().string()).finished)
+                found.emplace_back(entry.last_write_time(), entry.path().string());
+        } catch (const std::exception&) {
+            // Not one of ours or unreadable; leave it alone
+        }
+    }
+    std::sort(found.begin(), found.end());
+    std::vector<std::string> paths;
+    for (auto& f : found) paths.push_back(std::move(f.second));
+    return paths;
+}
+
+std::string journalPathFor(const std::string& csvPath) {
+    return std::filesystem::path(csvPath).replace_extension(".journal").string();
+}
+
+CsvFlushPolicy SweepJournal::defaultFlush() {
+    CsvFlushPolicy policy;
+    policy.bufferBytes = 16 * sizeof(JournalRecord);
+    policy.everyRows = 16;
+    policy.everySeconds = 1.0;
+    return policy;
+}
+
+// Header and metadata are written at once, so even an immediate crash leaves a readable journal
+SweepJournal::SweepJournal(const std::string& path, const RunMetadata& metadata, const CsvFlushPolicy& policy,
+                           FsyncPolicy sync)
+    : path_(path), flushPolicy_(policy), syncPolicy_(sync), fd_(-1), points_(0), pointsSinceFlush_(0),
+      lastFlushNs_(steadyNs()) {
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd_ < 0) throw std::runtime_error("Failed to create " + path + ": " + std::strerror(errno));
+
+    std::string text;
+    for (const auto& [key, value] : metadata) text += key + "=" + value + "\n";
+    JournalHeader header{};
+    std::memcpy(header.magic, kJournalMagic, sizeof(kJournalMagic));
+    header.version = kJournalVersion;
+    header.metadataSize = static_cast<std::uint32_t>(text.size());
+    std::uint32_t crc = crc32(reinterpret_cast<const std::uint8_t*>(text.data()), text.size());
+
+    buf_.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    buf_ += text;
+    buf_.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+    flush();
+}
+
+SweepJournal::SweepJournal(const std::string& path, const JournalContents& contents, const CsvFlushPolicy& policy,
+                           FsyncPolicy sync)
+    : path_(path), flushPolicy_(policy), syncPolicy_(sync), fd_(-1), points_(contents.points.size()),
+      pointsSinceFlush_(0), lastFlushNs_(steadyNs()) {
+    if (contents.finished) throw std::runtime_error("Journal already finished: " + path);
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd_ < 0) throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    if (::ftruncate(fd_, static_cast<off_t>(contents.validBytes)) != 0 ||
+        ::lseek(fd_, 0, SEEK_END) != static_cast<off_t>(contents.validBytes)) {
+        ::close(fd_);
+        fd_ = -1;
+        throw std::runtime_error("Failed to reopen " + path + ": " + std::strerror(errno));
+    }
+}
+
+SweepJournal::~SweepJournal() {
+    try {
+        close();
+    } catch (...) {}
+}
+
+const std::string& SweepJournal::path() const {
+    return path_;
+}
+
+std::size_t SweepJournal::points() const {
+    return points_;
+}
+
+void SweepJournal::appendRecord(JournalRecord record) {
+    record.crc = recordCrc(record);
+    buf_.append(reinterpret_cast<const char*>(&record), sizeof(record));
+}
+
+void SweepJournal::append(const AcquiredPoint& a) {
+    const SweepPoint& p = a.point;
+    appendRecord({JournalTag::Point, p.index, p.setVoltage, p.voltage, p.current, p.settleTime, a.monotonicNs,
+                  a.wallNs, 0, 0});
+    ++points_;
+    ++pointsSinceFlush_;
+
+    bool due = buf_.size() >= flushPolicy_.bufferBytes ||
+               (flushPolicy_.everyRows && pointsSinceFlush_ >= flushPolicy_.everyRows) ||
+               (flushPolicy_.everySeconds > 0 && (steadyNs() - lastFlushNs_) >= flushPolicy_.everySeconds * 1e9);
+    if (due) flush();
+}
+
+void SweepJournal::flush() {
+    if (fd_ < 0) throw std::runtime_error("Journal is closed: " + path_);
+    if (!buf_.empty()) {
+        ScopedTimer t("journal.flush");
+        const char* data = buf_.data();
+        std::size_t left = buf_.size();
+        while (left > 0) {
+            ssize_t n = ::write(fd_, data, left);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("Failed to write " + path_ + ": " + std::strerror(errno));
+            data += n;
+            left -= static_cast<std::size_t>(n);
+        }
+        buf_.clear();
+        if (syncPolicy_ == FsyncPolicy::OnFlush) ::fdatasync(fd_);
+    }
+    pointsSinceFlush_ = 0;
+    lastFlushNs_ = steadyNs();
+}
+
+void SweepJournal::finish() {
+    appendRecord({JournalTag::End, -1, 0, 0, 0, 0, 0, 0, 0, 0});
+    close();
+}
+
+// A failed final write still closes the file (the unwritten records are dropped;
+// the reader stops at the last whole record) before the error is rethrown
+void SweepJournal::close() {
+    if (fd_ < 0) return;
+    std::exception_ptr error;
+    try {
+        flush();
+    } catch (...) {
+        error = std::current_exception();
+        buf_.clear();
+    }
+    if (!error && syncPolicy_ != FsyncPolicy::Never) ::fdatasync(fd_);
+    ::close(fd_);
+    fd_ = -1;
+    if (error) std::rethrow_exception(error);
+}
+
+void runJournaledSweep(MeasurementManager& meas, SweepPlan plan, SweepJournal& journal,
+                       const std::vector<AcquiredPoint>& done,
+                       const std::function<void(const AcquiredPoint&)>& onPoint, int retries) {
+    // Every point of the run by index, and which of them onPoint has seen
+    std::vector<AcquiredPoint> byIndex;
+    std::vector<char> have, delivered;
+    int last = -1;  // Index of the most recent measurement
+    auto remember = [&](const AcquiredPoint& a) {
+        if (a.point.index < 0) return;
+        std::size_t i = static_cast<std::size_t>(a.point.index);
+        if (i >= byIndex.size()) {
+            byIndex.resize(i + 1);
+            have.resize(i + 1, 0);
+            delivered.resize(i + 1, 0);
+        }
+        byIndex[i] = a;
+        have[i] = 1;
+        last = a.point.index;
+    };
+    auto deliver = [&](std::size_t i) {
+        if (i >= have.size() || !have[i] || delivered[i]) return;
+        delivered[i] = 1;
+        onPoint(byIndex[i]);
+    };
+    for (const auto& a : done) remember(a);
+
+    plan.onMeasured = [&](const SweepPoint& p) {
+        AcquiredPoint a = AcquiredPoint::stamp(p);
+        journal.append(a);
+        remember(a);
+    };
+
+    for (int attempt = 0;; ++attempt) {
+        // Points are measured in index order, so the first gap is where to continue
+        std::size_t first = 0;
+        while (first < have.size() && have[first]) ++first;
+        plan.firstPoint = static_cast<int>(first);
+        plan.resumed.clear();
+        for (std::size_t i = 0; i < first; ++i) plan.resumed.push_back(byIndex[i].point);
+
+        // Uniform sweeps report in index order, so earlier points go out first;
+        // adaptive sweeps report every point (resumed ones included) at the end
+        if (!plan.adaptive) {
+            for (std::size_t i = 0; i < first; ++i) deliver(i);
+            if (first >= static_cast<std::size_t>(std::max(plan.points, 0))) return;
+        }
+
+        try {
+            if (first > 0) {
+                // Back to where the source was before the interruption, so the next step is a small one
+                ScopedTimer t("journal.restore");
+                meas.sendBatch({":SOUR:VOLT " + formatReal(byIndex[last].point.setVoltage), ":OUTP ON"});
+            }
+            runSweep(meas, plan, [&](const SweepPoint& p) { deliver(static_cast<std::size_t>(p.index)); });
+            return;
+        } catch (const std::runtime_error& e) {
+            journal.flush();
+            if (attempt >= retries) throw;
+            int pause = std::min(1 << attempt, 30);
+            profileCount("journal.retries");
+            std::cerr << "[!] Sweep interrupted at point " << journal.points() << " (" << e.what()
+                      << "), continuing in " << pause << " s\n";
+            std::this_thread::sleep_for(std::chrono::seconds(pause));
+        }
+    }
+}
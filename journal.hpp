@@ -0,0 +1,128 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "csv_writer.hpp"
+#include "run_file.hpp"
+#include "sweep.hpp"
+
+// Append-only record of one sweep, written while it runs so an interrupted
+// run can be continued instead of repeated.
+//
+// Layout (host byte order):
+//   JournalHeader                    16 bytes at offset 0
+//   metadata                         "key=value\n" text (plan, endpoint, output paths)
+//   metadata CRC-32                  4 bytes
+//   records                          JournalRecord each, one per measured point,
+//                                    and a final end record once the run completed
+//
+// Every record carries its own CRC, so a record torn by a crash is detected and
+// dropped when the journal is read back.
+
+struct JournalHeader {
+    char magic[8];               // "CDAJRNL\0"
+    std::uint32_t version;       // kJournalVersion
+    std::uint32_t metadataSize;
+};
+static_assert(sizeof(JournalHeader) == 16, "Journal header must stay 16 bytes");
+
+enum class JournalTag : std::uint32_t {
+    Point = 0x50544e4a,   // One measured point
+    End = 0x444e454a      // The sweep finished; nothing to resume
+};
+
+struct JournalRecord {
+    JournalTag tag;
+    std::int32_t index;
+    double setVoltage;
+    double voltage;
+    double current;
+    double settleTime;
+    std::int64_t monotonicNs;
+    std::int64_t wallNs;
+    std::uint32_t reserved;
+    std::uint32_t crc;           // CRC-32 of the bytes before it
+};
+static_assert(sizeof(JournalRecord) == 64, "Journal record must stay 64 bytes");
+
+constexpr std::uint32_t kJournalVersion = 1;
+
+// Everything a journal holds, as read back
+struct JournalContents {
+    RunMetadata metadata;
+    std::vector<AcquiredPoint> points;   // In measurement order
+    bool finished = false;               // End record present
+    std::uint64_t validBytes = 0;        // Length up to the last intact record
+
+    // Metadata value for key (empty if missing)
+    std::string value(const std::string& key) const;
+};
+
+// Read a journal, stopping at the first torn or corrupt record (throws if the header is unreadable)
+JournalContents readJournal(const std::string& path);
+
+// Unfinished journals (*.journal) in dir, oldest first
+std::vector<std::string> findUnfinishedJournals(const std::string& dir);
+
+// Journal path kept next to a run's CSV file
+std::string journalPathFor(const std::string& csvPath);
+
+// Appends points to a journal. Records are buffered and written in batches as
+// set by the flush policy (rows = points), so journaling costs a memcpy per
+// point and one write() per batch; a crash loses at most one batch.
+class SweepJournal {
+public:
+    // Start a new journal (fails if the file already exists)
+    SweepJournal(const std::string& path, const RunMetadata& metadata, const CsvFlushPolicy& flush = defaultFlush(),
+                 FsyncPolicy sync = FsyncPolicy::OnClose);
+
+    // Continue an unfinished journal: a torn tail is cut off, new points go after the intact ones
+    SweepJournal(const std::string& path, const JournalContents& contents, const CsvFlushPolicy& flush = defaultFlush(),
+                 FsyncPolicy sync = FsyncPolicy::OnClose);
+    ~SweepJournal();
+
+    SweepJournal(const SweepJournal&) = delete;
+    SweepJournal& operator=(const SweepJournal&) = delete;
+
+    // Buffer one measured point
+    void append(const AcquiredPoint& point);
+
+    // Write buffered records now
+    void flush();
+
+    // Write the end record and close; the run no longer needs resuming
+    void finish();
+
+    // Flush, sync according to policy and close without marking the run finished
+    void close();
+
+    const std::string& path() const;
+    std::size_t points() const;   // Points in the journal, resumed ones included
+
+    // 16 points or one second, whichever comes first
+    static CsvFlushPolicy defaultFlush();
+
+private:
+    void appendRecord(JournalRecord record);
+
+    std::string path_;
+    CsvFlushPolicy flushPolicy_;
+    FsyncPolicy syncPolicy_;
+    int fd_;
+    std::string buf_;
+    std::size_t points_;
+    std::size_t pointsSinceFlush_;
+    std::int64_t lastFlushNs_;
+};
+
+// Run a sweep with every new point journaled. When the instrument fails mid-run
+// the session reconnects, the source is put back at the last measured voltage and
+// the sweep continues from the first missing point, up to `retries` times with
+// growing pauses. Points in `done` (from an earlier, interrupted run) are reused,
+// not measured again. onPoint sees every point of the run exactly once, with the
+// time it was measured. Rethrows the last error when the retries are used up;
+// the journal then stays unfinished for a later restart.
+void runJournaledSweep(MeasurementManager& meas, SweepPlan plan, SweepJournal& journal,
+                       const std::vector<AcquiredPoint>& done,
+                       const std::function<void(const AcquiredPoint&)>& onPoint, int retries = 5);
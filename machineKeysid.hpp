@@ -13,6 +13,7 @@
 #include <iomanip>
 #include <filesystem>
 #include <stdexcept>
+#include <memory>
 
 // System includes
 #include <ncurses.h>
@@ -29,4 +30,14 @@
 #include "measurement_manager.hpp"
 #include "data_manager.hpp"
 #include "PyPlotter.hpp"
+#include "sweep.hpp"
+#include "grid_sweep.hpp"
+#include "pipeline.hpp"
+#include "profiler.hpp"
+#include "csv_writer.hpp"
+#include "run_file.hpp"
+#include "plot_renderer.hpp"
+#include "job_runner.hpp"
+#include "journal.hpp"
+#include "dashboard.hpp"
 
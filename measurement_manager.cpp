@@ -1,5 +1,10 @@
 #include "measurement_manager.hpp"
+#include "profiler.hpp"
 #include <iostream>
+#include <cstdlib>
+#include <charconv>
+#include <cmath>
+#include <limits>
 
 
 // Constructor to set IP and port of target instrument
@@ -15,24 +20,143 @@ int Machine::port() const {
     return port_;
 }
 
+// Accessor for cached identification string
+const std::string& Machine::idn() const {
+    return idn_;
+}
+
+// Remember identification string so it is not re-queried
+void Machine::setIdn(const std::string& idn) {
+    idn_ = idn;
+}
+
 // Constructor that accepts a Machine object (defines connection target)
-MeasurementManager::MeasurementManager(const Machine& machine) : machine_(machine) {}
+MeasurementManager::MeasurementManager(const Machine& machine)
+    : machine_(machine), session_(machine.ip(), machine.port()), listSupport_(-1), averSupport_(-1),
+      format_(DataFormat::Ascii), byteOrder_(nativeByteOrder()) {}
+
+// SCPI error queue entries look like '+0,"No error"'
+static bool isNoError(const std::string& reply) {
+    return std::strtol(reply.c_str(), nullptr, 10) == 0;
+}
 
 // Repeat a command multiple times, calculate and return average of results
 double MeasurementManager::measureAverage(const std::string& command, int repeats) {
+    AverageOptions options;
+    options.minSamples = options.maxSamples = repeats;
+    options.outlierThreshold = 0.0;
+    AverageResult r = measureStatistics(command, options);
+    measurements_.emplace_back(command, formatReal(r.mean));  // Round-trip exact, not 6 digits
+    return r.mean;
+}
+
+// Numeric reply in either data format; a malformed ASCII reply is reported, not thrown
+bool MeasurementManager::queryReal(const std::string& command, double& value) {
+    if (format_ == DataFormat::Real64) return queryReals(command, std::span<double>(&value, 1)) == 1;
+    std::string reply = sendCommand(command);
+    const char* begin = reply.data();
+    const char* end = begin + reply.size();
+    while (begin < end && (*begin == ' ' || *begin == '+')) ++begin;
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\r' || end[-1] == '\n')) --end;
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    return ec == std::errc() && ptr == end;
+}
+
+// Welford accumulation while reading; every reading is kept for the final
+// median/MAD pass. The stop rule uses all readings, so outliers only ever
+// make it sample more.
+AverageResult MeasurementManager::measureStatistics(const std::string& command, const AverageOptions& options) {
+    ScopedTimer t("measure.statistics");
+    AverageResult result;
+    RunningStats stats;
     std::vector<double> values;
-    for (int i = 0; i < repeats; ++i) {
-        std::string response = sendCommand(command);
-        try {
-            double val = std::stod(response);
-            values.push_back(val);
-        } catch (...) {}
+    int minSamples = std::max(1, std::min(options.minSamples, options.maxSamples));
+    values.reserve(std::max(0, options.maxSamples));
+
+    // Allowed half width: the looser of the enabled targets
+    auto target = [&](double mean) {
+        double limit = 0.0;
+        if (options.targetRelative > 0) limit = options.targetRelative * std::fabs(mean);
+        if (options.targetAbsolute > 0) limit = std::max(limit, options.targetAbsolute);
+        return limit;
+    };
+    bool stopRule = options.targetRelative > 0 || options.targetAbsolute > 0;
+
+    for (int i = 0; i < options.maxSamples; ++i) {
+        double value;
+        if (!queryReal(command, value)) {
+            ++result.parseFailures;
+            profileCount("measure.parse_failures");
+            continue;
+        }
+        values.push_back(value);
+        stats.add(value);
+        if (!stopRule || static_cast<int>(stats.count()) < minSamples) continue;
+
+        double limit = target(stats.mean());
+        if (confidenceHalfWidth(stats, options.confidence) <= limit) {
+            result.converged = true;
+            break;
+        }
+
+        // Readings still needed at the observed noise; one instrument-averaged
+        // reading replaces them when the instrument supports it. The noise is
+        // only known from two readings on (and a NaN reading leaves it unknown).
+        if (options.instrumentAveraging && stats.count() >= 2 && supportsInstrumentAveraging()) {
+            double tq = studentT(options.confidence, stats.count() - 1);
+            double needed = limit > 0 ? std::ceil(std::pow(tq * stats.stddev() / limit, 2)) : options.maxSamples;
+            int remaining = !std::isfinite(needed) ? 0
+                            : static_cast<int>(std::min<double>(needed, options.maxSamples)) - static_cast<int>(stats.count());
+            if (remaining >= 2) {
+                double averaged;
+                bool ok;
+                try {
+                    sendBatch({":SENS:AVER:COUN " + std::to_string(remaining), ":SENS:AVER:STAT ON"});
+                    ok = queryReal(command, averaged);
+                } catch (...) {
+                    // Never leave averaging on for later readings; the query's error wins
+                    try { sendCommand(":SENS:AVER:STAT OFF"); } catch (...) {}
+                    throw;
+                }
+                sendCommand(":SENS:AVER:STAT OFF");
+                if (ok) {
+                    double n = static_cast<double>(stats.count());
+                    result.instrumentSamples = remaining;
+                    result.mean = (stats.mean() * n + averaged * remaining) / (n + remaining);
+                    result.stddev = stats.stddev();
+                    result.halfWidth = tq * stats.stddev() / std::sqrt(n + remaining);
+                    result.min = std::min(stats.min(), averaged);
+                    result.max = std::max(stats.max(), averaged);
+                    result.samples = static_cast<int>(stats.count());
+                    result.converged = result.halfWidth <= target(result.mean);
+                    profileCount("measure.samples", result.samples);
+                    profileCount("measure.instrument_samples", remaining);
+                    return result;
+                }
+                ++result.parseFailures;
+                profileCount("measure.parse_failures");
+            }
+        }
+    }
+
+    if (values.empty()) throw std::runtime_error("No numeric reply to " + command);
+
+    // Robust pass: drop readings far from the median, then recompute
+    result.rejected = static_cast<int>(rejectOutliers(values, options.outlierThreshold));
+    if (result.rejected > 0) {
+        stats.clear();
+        for (double v : values) stats.add(v);
+        profileCount("measure.rejected", result.rejected);
     }
-    if (values.empty()) return 0.0;
-    double sum = std::accumulate(values.begin(), values.end(), 0.0);
-    double avg = sum / values.size();
-    measurements_.emplace_back(command, std::to_string(avg));
-    return avg;
+    result.mean = stats.mean();
+    result.stddev = stats.stddev();
+    result.halfWidth = stats.count() > 1 ? confidenceHalfWidth(stats, options.confidence) : 0.0;
+    result.min = stats.min();
+    result.max = stats.max();
+    result.samples = static_cast<int>(stats.count());
+    if (stopRule) result.converged = result.halfWidth <= target(result.mean);
+    profileCount("measure.samples", result.samples);
+    return result;
 }
 
 // Repeat a command multiple times and return all results
@@ -48,15 +172,20 @@ std::vector<std::string> MeasurementManager::repeatMeasurement(const std::string
 
 // Save all command-response pairs to a binary file
 void MeasurementManager::saveToBinaryFile(const std::string& filepath) {
-    std::ofstream out(filepath, std::ios::binary);
-    for (const auto& [cmd, res] : measurements_) {
-        uint32_t cmd_len = cmd.size();
-        uint32_t res_len = res.size();
-        out.write(reinterpret_cast<const char*>(&cmd_len), sizeof(cmd_len));
-        out.write(cmd.c_str(), cmd_len);
-        out.write(reinterpret_cast<const char*>(&res_len), sizeof(res_len));
-        out.write(res.c_str(), res_len);
-    }
+    writeCommandLog(filepath, measurements_);
+}
+
+void MeasurementManager::recordTraffic(bool on) {
+    session_.setCapture(on);
+}
+
+void MeasurementManager::saveTrafficLog(const std::string& filepath) {
+    writeCommandLog(filepath, session_.captured());
+}
+
+// Commands sent from now on must match the recording in order
+void MeasurementManager::replayFrom(const std::string& filepath) {
+    session_.replay(std::make_shared<CommandLogReader>(filepath));
 }
 
 // Ask user for number of repetitions, then measure average
@@ -75,37 +204,250 @@ std::vector<std::string> MeasurementManager::askRepeatsAndMeasure(const std::str
     return repeatMeasurement(command, times);
 }
 
-// Send SCPI command via socket, receive response
+// Send SCPI command over the persistent session; only queries read a response
 std::string MeasurementManager::sendCommand(const std::string& command) {
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) throw std::runtime_error("Socket creation failed");
+    if (command.find('?') == std::string::npos) {
+        ScopedTimer t("scpi.command");
+        session_.command(command);
+        return "";
+    }
+    ScopedTimer t("scpi.query");
+    profileCount("scpi.round_trips");
+    return session_.query(command);
+}
+
+// Send a batch of commands in one network round trip and split replies per query
+std::vector<std::string> MeasurementManager::sendBatch(const std::vector<std::string>& commands,
+                                                       BatchMode mode) {
+    if (commands.empty()) return {};
+    ScopedTimer t("scpi.batch");
+
+    std::size_t queries = 0;
+    std::string message;
+    for (const auto& cmd : commands) {
+        if (cmd.find('?') != std::string::npos) ++queries;
+        if (!message.empty()) message += (mode == BatchMode::Joined) ? ";" : "\n";
+        // Inside a joined message a header without ':' would be relative to the previous one
+        if (mode == BatchMode::Joined && cmd[0] != ':' && cmd[0] != '*') message += ':';
+        message += cmd;
+    }
+
+    if (queries == 0) {
+        session_.command(message);
+        return {};
+    }
+    profileCount("scpi.round_trips");
 
-    sockaddr_in serv_addr{};
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(machine_.port());
-    inet_pton(AF_INET, machine_.ip().c_str(), &serv_addr.sin_addr);
+    if (mode == BatchMode::Pipelined)
+        return session_.transact(message, queries);
 
-    if (connect(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0)
-        throw std::runtime_error("Connect failed");
+    // Joined queries come back as one response message separated by ';'
+    std::vector<std::string> replies;
+    session_.exchange(message, [&] {
+        std::string reply = session_.readLine();
+        replies.clear();
+        std::size_t start = 0;
+        while (true) {
+            std::size_t sep = reply.find(';', start);
+            replies.push_back(reply.substr(start, sep - start));
+            if (sep == std::string::npos) break;
+            start = sep + 1;
+        }
+        if (replies.size() != queries)
+            throw ScpiError(ScpiFault::Garbled, "Batch reply has " + std::to_string(replies.size()) +
+                                                    " fields, expected " + std::to_string(queries));
+    });
+    return replies;
+}
 
-    send(sockfd, command.c_str(), command.length(), 0);
-    send(sockfd, "\n", 1, 0);  // SCPI commands are newline-terminated
-    char buffer[1024] = {0};
-    recv(sockfd, buffer, sizeof(buffer), 0);
-    close(sockfd);
-    return std::string(buffer);
+// Query *IDN? once and reuse the cached value afterwards
+const std::string& MeasurementManager::identify() {
+    if (machine_.idn().empty()) machine_.setIdn(sendCommand("*IDN?"));
+    return machine_.idn();
 }
 
-// Get basic ID, voltage, and current readings from instrument
-std::tuple<std::string, double, double> MeasurementManager::getBasicMeasurement() {
-    std::string name = sendCommand("*IDN?");
-    std::string v_str = sendCommand(":MEAS:VOLT?");
-    std::string c_str = sendCommand(":MEAS:CURR?");
+// Accessor for the connection target
+const Machine& MeasurementManager::machine() const {
+    return machine_;
+}
+
+void MeasurementManager::setLinkPolicy(const ScpiPolicy& policy) {
+    session_.setPolicy(policy);
+}
+
+const ScpiLinkStats& MeasurementManager::linkStats() const {
+    return session_.stats();
+}
 
+// Select ASCII or binary transfer on the instrument and remember it for decoding
+void MeasurementManager::setDataFormat(DataFormat format, ByteOrder order) {
+    if (format == DataFormat::Real64) {
+        sendBatch({":FORM:DATA REAL,64", order == ByteOrder::Swapped ? ":FORM:BORD SWAP" : ":FORM:BORD NORM"});
+    } else {
+        sendCommand(":FORM:DATA ASC");
+    }
+    format_ = format;
+    byteOrder_ = order;
+}
+
+DataFormat MeasurementManager::dataFormat() const {
+    return format_;
+}
+
+// A reply that is not a number list is a garbled reply: the session resyncs by reconnecting
+static std::size_t parseReplyReals(std::string_view line, std::span<double> out) {
+    try {
+        return parseAsciiReals(line, out);
+    } catch (const std::runtime_error& e) {
+        throw ScpiError(ScpiFault::Garbled, e.what());
+    }
+}
+
+// Decode one response into a caller-provided buffer
+std::size_t MeasurementManager::readReals(std::span<double> out) {
+    ScopedTimer t("scpi.read_reals");
+    if (format_ == DataFormat::Ascii) {
+        std::string line = session_.readLine();
+        return parseReplyReals(line, out);
+    }
+
+    std::size_t bytes = session_.readBlockHeader();
+    if (bytes % sizeof(double) != 0) throw ScpiError(ScpiFault::Garbled, "Block length is not a multiple of 8 bytes");
+    std::size_t count = bytes / sizeof(double);
+    if (count > out.size()) throw ScpiError(ScpiFault::Garbled, "Binary block larger than destination");
+    session_.readExact(out.data(), bytes);
+    if (byteOrder_ != nativeByteOrder()) swapReal64(out.data(), count);
+    session_.readLine();  // Consume the message terminator after the block
+    return count;
+}
+
+// Decode one response into a vector sized from the reply itself
+std::vector<double> MeasurementManager::readReals() {
+    ScopedTimer t("scpi.read_reals");
+    std::vector<double> values;
+    if (format_ == DataFormat::Ascii) {
+        std::string line = session_.readLine();
+        values.resize(countAsciiReals(line));
+        values.resize(parseReplyReals(line, values));
+        return values;
+    }
+
+    std::size_t bytes = session_.readBlockHeader();
+    if (bytes % sizeof(double) != 0) throw ScpiError(ScpiFault::Garbled, "Block length is not a multiple of 8 bytes");
+    values.resize(bytes / sizeof(double));
+    session_.readExact(values.data(), bytes);
+    if (byteOrder_ != nativeByteOrder()) swapReal64(values.data(), values.size());
+    session_.readLine();  // Consume the message terminator after the block
+    return values;
+}
+
+// Numeric query decoded straight into the caller's buffer
+std::size_t MeasurementManager::queryReals(const std::string& query, std::span<double> out) {
+    profileCount("scpi.round_trips");
+    std::size_t count = 0;
+    session_.exchange(query, [&] { count = readReals(out); });
+    return count;
+}
+
+// Numeric query returning every value of the reply
+std::vector<double> MeasurementManager::queryReals(const std::string& query) {
+    profileCount("scpi.round_trips");
+    std::vector<double> values;
+    session_.exchange(query, [&] { values = readReals(); });
+    return values;
+}
+
+// Probe list mode by switching to it and reading the error queue
+bool MeasurementManager::supportsListSweep() {
+    if (listSupport_ < 0) {
+        sendCommand("*CLS");
+        auto err = sendBatch({":SOUR:VOLT:MODE LIST", ":SYST:ERR?"});
+        listSupport_ = isNoError(err[0]) ? 1 : 0;
+        sendCommand(":SOUR:VOLT:MODE FIX");
+    }
+    return listSupport_ == 1;
+}
+
+// Probe SENS:AVER the same way as list mode: set it and read the error queue
+bool MeasurementManager::supportsInstrumentAveraging() {
+    if (averSupport_ < 0) {
+        sendCommand("*CLS");
+        auto err = sendBatch({":SENS:AVER:COUN 1", ":SYST:ERR?"});
+        averSupport_ = isNoError(err[0]) ? 1 : 0;
+    }
+    return averSupport_ == 1;
+}
+
+// Run a whole voltage list on the instrument and read all points back in one transfer
+std::vector<std::pair<double, double>> MeasurementManager::listSweep(const std::vector<double>& voltages,
+                                                                      double sourceDelay) {
+    if (voltages.empty()) return {};
+
+    std::string list;
+    for (double v : voltages) {
+        if (!list.empty()) list += ',';
+        list += formatReal(v);
+    }
+
+    // Program source list, trigger count and per-point delay, then check for errors
+    auto err = sendBatch({
+        "*CLS",
+        ":SOUR:FUNC:MODE VOLT",
+        ":SOUR:VOLT:MODE LIST",
+        ":SOUR:LIST:VOLT " + list,
+        ":SENS:FUNC \"VOLT\",\"CURR\"",
+        ":TRIG:SOUR AINT",
+        ":TRIG:COUN " + std::to_string(voltages.size()),
+        ":TRIG:ACQ:DEL " + formatReal(sourceDelay),
+        ":SYST:ERR?"
+    });
+    if (!isNoError(err[0]))
+        throw std::runtime_error("List sweep setup rejected: " + err[0]);
+
+    // Start once and wait for completion: the deadline covers the whole list (delay and
+    // per-point acquisition), and a failed :INIT is not repeated. Fetching is safe to
+    // repeat, in one pipelined round trip.
+    double pointSeconds = sourceDelay * 1.5 + session_.policy().listPointTime;
+    double listSeconds = static_cast<double>(voltages.size()) * pointSeconds;
+    profileCount("scpi.round_trips");
+    session_.query(":OUTP ON;:INIT;*OPC?", false, session_.policy().replyTimeout + listSeconds);
+    profileCount("scpi.round_trips");
+    std::vector<double> volts, currs;
+    session_.exchange(":FETC:ARR:VOLT?\n:FETC:ARR:CURR?", [&] {
+        volts = readReals();
+        currs = readReals();
+    });
+    sendCommand(":SOUR:VOLT:MODE FIX");
+
+    if (volts.size() != voltages.size() || currs.size() != voltages.size())
+        throw std::runtime_error("List sweep returned " + std::to_string(volts.size()) + "/" +
+                                 std::to_string(currs.size()) + " readings, expected " +
+                                 std::to_string(voltages.size()));
+
+    std::vector<std::pair<double, double>> result;
+    result.reserve(voltages.size());
+    for (std::size_t i = 0; i < voltages.size(); ++i) result.emplace_back(volts[i], currs[i]);
+    return result;
+}
+
+// Get basic ID, voltage, and current readings from instrument in one round trip
+std::tuple<std::string, double, double> MeasurementManager::getBasicMeasurement() {
+    const std::string& name = identify();
     double voltage = 0.0, current = 0.0;
-    try { voltage = std::stod(v_str); } catch (...) {}
-    try { current = std::stod(c_str); } catch (...) {}
+
+    // Binary replies cannot be ';'-joined, so pipeline the two queries instead
+    if (format_ == DataFormat::Real64) {
+        profileCount("scpi.round_trips");
+        session_.exchange(":MEAS:VOLT?\n:MEAS:CURR?", [&] {
+            readReals(std::span<double>(&voltage, 1));
+            readReals(std::span<double>(&current, 1));
+        });
+        return {name, voltage, current};
+    }
+
+    auto replies = sendBatch({":MEAS:VOLT?", ":MEAS:CURR?"});
+    try { voltage = std::stod(replies[0]); } catch (...) {}
+    try { current = std::stod(replies[1]); } catch (...) {}
 
     return {name, voltage, current};
 }
-
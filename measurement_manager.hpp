@@ -1,3 +1,4 @@
+#pragma once
 #include <string>
 #include <vector>
 #include <tuple>
@@ -9,6 +10,10 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <fstream>
+#include <span>
+#include "scpi_session.hpp"
+#include "scpi_block.hpp"
+#include "statistics.hpp"
 
 // Class representing a remote measurement device
 class Machine {
@@ -17,9 +22,51 @@ public:
     const std::string& ip() const;
     int port() const;
 
+    // Cached *IDN? reply (empty until the instrument has been identified)
+    const std::string& idn() const;
+    void setIdn(const std::string& idn);
+
 private:
     std::string ip_;
     int port_;
+    std::string idn_;
+};
+
+// How a batch of commands is put on the wire
+enum class BatchMode {
+    Joined,     // One program message, commands separated by ';'
+    Pipelined   // One line per command, all written before any reply is read
+};
+
+// Encoding of numeric responses as selected with FORM:DATA
+enum class DataFormat {
+    Ascii,    // Comma separated text (FORM:DATA ASC)
+    Real64    // IEEE 488.2 binary block of doubles (FORM:DATA REAL,64)
+};
+
+// When measureStatistics has taken enough readings
+struct AverageOptions {
+    int minSamples = 3;             // Always taken (noise estimate for the stop rule)
+    int maxSamples = 10;            // Hard cap per call
+    double targetRelative = 0.0;    // Stop once the CI half width is below this fraction of |mean| (0 = off)
+    double targetAbsolute = 0.0;    // ... or below this absolute value (0 = off)
+    double confidence = 0.95;
+    double outlierThreshold = 3.5;  // Modified z-score above which a reading is dropped (0 = keep all)
+    bool instrumentAveraging = false;  // Let the instrument average the remaining readings (SENS:AVER) if it can
+};
+
+// Outcome of measureStatistics
+struct AverageResult {
+    double mean = 0.0;
+    double stddev = 0.0;            // Of single host readings
+    double halfWidth = 0.0;         // Confidence interval half width of the mean
+    double min = 0.0;
+    double max = 0.0;
+    int samples = 0;                // Valid host readings used
+    int instrumentSamples = 0;      // Readings averaged on the instrument
+    int rejected = 0;               // Outliers dropped
+    int parseFailures = 0;          // Replies that were not a number
+    bool converged = false;         // Target precision reached
 };
 
 // Class to handle communication and data collection from Machine
@@ -27,9 +74,16 @@ class MeasurementManager {
 public:
     MeasurementManager(const Machine& machine);
 
-    // Measure a value multiple times and return the average
+    // Measure a value multiple times and return the average (throws if no reply parses)
     double measureAverage(const std::string& command, int repeats);
 
+    // Repeat a numeric query until the mean is known to the target precision or
+    // maxSamples is reached; outliers are rejected by median/MAD
+    AverageResult measureStatistics(const std::string& command, const AverageOptions& options);
+
+    // Check once whether the instrument averages readings itself (SENS:AVER)
+    bool supportsInstrumentAveraging();
+
     // Measure a value multiple times and return all results
     std::vector<std::string> repeatMeasurement(const std::string& command, int times);
 
@@ -39,17 +93,69 @@ public:
     // Prompt user for repeat count and return all responses
     std::vector<std::string> askRepeatsAndMeasure(const std::string& command);
 
-    // Send a command and return the response
+    // Send a command and return the response (empty for commands without '?')
     std::string sendCommand(const std::string& command);
 
+    // Send several commands and queries in one round trip, return one reply per query
+    std::vector<std::string> sendBatch(const std::vector<std::string>& commands,
+                                       BatchMode mode = BatchMode::Joined);
+
+    // Return the instrument *IDN? string, querying it only once per Machine
+    const std::string& identify();
+
+    // Access the connection target
+    const Machine& machine() const;
+
+    // Timeouts and retries of the instrument link, and how often they were needed
+    void setLinkPolicy(const ScpiPolicy& policy);
+    const ScpiLinkStats& linkStats() const;
+
+    // Switch numeric responses between ASCII and binary REAL,64 blocks
+    void setDataFormat(DataFormat format, ByteOrder order = nativeByteOrder());
+    DataFormat dataFormat() const;
+
+    // Send a numeric query and decode the reply straight into out, returns values written
+    std::size_t queryReals(const std::string& query, std::span<double> out);
+
+    // Send a numeric query and return all decoded values
+    std::vector<double> queryReals(const std::string& query);
+
+    // Check once whether the instrument accepts the list (sweep) source mode
+    bool supportsListSweep();
+
+    // Program a voltage list, run it on the instrument and fetch all V/I pairs at once
+    std::vector<std::pair<double, double>> listSweep(const std::vector<double>& voltages,
+                                                     double sourceDelay);
+
     // Perform basic voltage/current measurement and return ID
     std::tuple<std::string, double, double> getBasicMeasurement();
 
     // Save collected command-response pairs to binary file
     void saveToBinaryFile(const std::string& filepath);
 
+    // Record the raw session traffic (every message and the bytes it got back)
+    void recordTraffic(bool on);
+
+    // Save the recorded traffic in the saveToBinaryFile log format
+    void saveTrafficLog(const std::string& filepath);
+
+    // Answer all further commands from a recorded log instead of the instrument
+    void replayFrom(const std::string& filepath);
+
 private:
     Machine machine_;
-    std::vector<std::pair<std::string, std::string>> measurements_;
+    ScpiSession session_;  // One connection kept open for the whole run
+    int listSupport_;      // -1 unknown, 0 no, 1 yes
+    int averSupport_;      // -1 unknown, 0 no, 1 yes
+    DataFormat format_;
+    ByteOrder byteOrder_;
+
+    // One numeric reading, false if the reply is not a number
+    bool queryReal(const std::string& command, double& value);
+
+    // Read one numeric response in the current data format
+    std::size_t readReals(std::span<double> out);
+    std::vector<double> readReals();
+    std::vector<CommandRecord> measurements_;
 };
 
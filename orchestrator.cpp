@@ -0,0 +1,70 @@
+#include "orchestrator.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+// Remember the pool size; threads are only started in run()
+Orchestrator::Orchestrator(std::size_t threads) : threads_(threads) {}
+
+// Learned settle times belong to one instrument, and concurrent sweeps saving
+// one shared table would overwrite each other: settle_table.txt becomes
+// settle_table_<host>_<port>.txt
+static void endpointTable(SettleConfig& settle, const Machine& machine) {
+    if (settle.mode != SettleMode::Table || settle.tablePath.empty()) return;
+    std::filesystem::path path(settle.tablePath);
+    std::string stem = path.stem().string() + "_" + machine.ip() + "_" + std::to_string(machine.port());
+    settle.tablePath = (path.parent_path() / (stem + path.extension().string())).string();
+}
+
+// Add one instrument endpoint with its own sweep plan
+void Orchestrator::add(const std::string& name, const Machine& machine, const SweepPlan& plan) {
+    add(InstrumentJob{name, machine, plan});
+}
+
+void Orchestrator::add(InstrumentJob job) {
+    endpointTable(job.plan.settle, job.machine);
+    if (job.grid) endpointTable(job.grid->settle, job.machine);
+    jobs_.push_back(std::move(job));
+}
+
+// Workers pull jobs off a shared counter; each job has its own connection and DataManager
+std::vector<InstrumentRun> Orchestrator::run(const JobPointCallback& onPoint) {
+    std::vector<InstrumentRun> runs(jobs_.size());
+    std::atomic<std::size_t> next{0};
+
+    auto worker = [&]() {
+        for (std::size_t i = next++; i < jobs_.size(); i = next++) {
+            const InstrumentJob& job = jobs_[i];
+            InstrumentRun& out = runs[i];
+            out.name = job.name;
+
+            auto t0 = std::chrono::steady_clock::now();
+            try {
+                std::optional<MeasurementManager> own;
+                MeasurementManager& meas = job.session ? *job.session : own.emplace(job.machine);
+                std::string idn = meas.identify();
+                if (job.grid) {
+                    runCapacitanceSweep(meas, *job.grid, out.data);
+                } else {
+                    out.data.reserve(job.plan.points);
+                    runSweep(meas, job.plan, [&](const SweepPoint& p) {
+                        out.data.addMeasurement(idn, p.voltage, p.current, p.settleTime, p.setVoltage);
+                        if (onPoint) onPoint(i, p);
+                    });
+                }
+                out.ok = true;
+            } catch (const std::exception& e) {
+                out.error = e.what();
+            }
+            out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        }
+    };
+
+    std::size_t count = threads_ == 0 ? jobs_.size() : std::min(threads_, jobs_.size());
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < count; ++t) pool.emplace_back(worker);
+    for (auto& t : pool) t.join();
+    return runs;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include "measurement_manager.hpp"
+#include "data_manager.hpp"
+#include "sweep.hpp"
+#include "grid_sweep.hpp"
+
+// One instrument endpoint and the sweep to run on it
+struct InstrumentJob {
+    std::string name;
+    Machine machine;
+    SweepPlan plan;
+    std::optional<CapacitancePlan> grid;       // Measure this C-V grid instead of the I-V sweep
+    MeasurementManager* session = nullptr;     // Open connection to use (caller keeps it), else one is opened
+};
+
+// Outcome of one instrument's sweep
+struct InstrumentRun {
+    std::string name;
+    DataManager data;        // Per-instrument output
+    double seconds = 0.0;    // Wall time of this instrument's sweep
+    bool ok = false;
+    std::string error;       // Set when ok is false
+};
+
+// Called from worker threads for every I-V point: (job index, point). Must be thread-safe.
+using JobPointCallback = std::function<void(std::size_t, const SweepPoint&)>;
+
+// Runs sweeps on several instruments at once on a small pool of worker threads,
+// so total wall time approaches that of the slowest instrument. Give every job
+// its own endpoint; Table settling learns into one table file per endpoint.
+class Orchestrator {
+public:
+    // threads = 0 runs every job on its own thread
+    explicit Orchestrator(std::size_t threads = 0);
+
+    // Queue an instrument with its sweep plan
+    void add(const std::string& name, const Machine& machine, const SweepPlan& plan);
+
+    // Queue a job as given (a capacitance grid, or a sweep on an open session)
+    void add(InstrumentJob job);
+
+    // Run all queued jobs concurrently and wait for them; results keep the order of add()
+    std::vector<InstrumentRun> run(const JobPointCallback& onPoint = {});
+
+private:
+    std::size_t threads_;
+    std::vector<InstrumentJob> jobs_;
+};
@@ -0,0 +1,28 @@
+#include "pipeline.hpp"
+#include "profiler.hpp"
+#include <cstdio>
+
+void writeStageStats(std::ostream& out, const std::vector<StageStats>& stats) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-10s %10s %8s %10s %9s %10s %10s\n", "stage", "processed", "dropped",
+                  "max depth", "capacity", "busy (s)", "stall (s)");
+    out << line;
+    for (const auto& s : stats) {
+        std::snprintf(line, sizeof(line), "%-10s %10llu %8llu %10zu %9zu %10.3f %10.3f\n", s.name.c_str(),
+                      static_cast<unsigned long long>(s.processed), static_cast<unsigned long long>(s.dropped),
+                      s.maxDepth, s.capacity, s.busySeconds, s.blockedSeconds);
+        out << line;
+        if (!s.error.empty()) out << "  " << s.name << " failed: " << s.error << "\n";
+    }
+}
+
+// Counter names are copied by the profiler, so they can be built per stage
+void profileStageStats(const std::vector<StageStats>& stats) {
+    for (const auto& s : stats) {
+        std::string prefix = "pipeline." + s.name + ".";
+        profileCount((prefix + "processed").c_str(), static_cast<std::int64_t>(s.processed));
+        profileCount((prefix + "dropped").c_str(), static_cast<std::int64_t>(s.dropped));
+        profileCount((prefix + "max_depth").c_str(), static_cast<std::int64_t>(s.maxDepth));
+        profileCount((prefix + "stall_us").c_str(), static_cast<std::int64_t>(s.blockedSeconds * 1e6));
+    }
+}
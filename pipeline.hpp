@@ -0,0 +1,284 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bounded lock-free single-producer/single-consumer ring buffer.
+// One thread may push and one other thread may pop; neither ever takes a lock
+// or makes a system call. Capacity is rounded up to a power of two.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(std::size_t capacity) {
+        std::size_t cap = 2;
+        while (cap < capacity) cap *= 2;
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side: false if the queue is full
+    bool tryPush(const T& value) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ > mask_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ > mask_) return false;
+        }
+        slots_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: false if the queue is empty
+    bool tryPop(T& out) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) return false;
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate number of queued items (exact when called by either side)
+    std::size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    // Producer and consumer indices on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<std::size_t> head_{0};   // Next slot to pop
+    std::size_t tailCache_ = 0;                      // Consumer's view of tail_
+    alignas(64) std::atomic<std::size_t> tail_{0};   // Next slot to push
+    std::size_t headCache_ = 0;                      // Producer's view of head_
+    alignas(64) std::vector<T> slots_;
+    std::size_t mask_;
+};
+
+// What a stage's queue does when it is full
+enum class StagePolicy {
+    Block,   // Producer waits for space (nothing is lost)
+    Drop     // Item is discarded for this stage and counted
+};
+
+// Per-stage counters, readable while the pipeline runs
+struct StageStats {
+    std::string name;
+    std::size_t capacity = 0;
+    std::size_t depth = 0;            // Items queued right now
+    std::size_t maxDepth = 0;         // Highest depth seen by the producer
+    std::uint64_t processed = 0;
+    std::uint64_t dropped = 0;
+    double busySeconds = 0.0;         // Time spent inside the consumer function
+    double blockedSeconds = 0.0;      // Time the producer waited on a full queue
+    std::string error;                // Set once the consumer function threw
+};
+
+// Print one line per stage
+void writeStageStats(std::ostream& out, const std::vector<StageStats>& stats);
+
+// Publish stage statistics as profiler counters (pipeline.<stage>.<metric>)
+void profileStageStats(const std::vector<StageStats>& stats);
+
+// Fan-out pipeline: one producer (acquisition) pushes every item to each stage's
+// own SPSC queue; each stage consumes on its own thread. A slow stage only fills
+// its own queue and, depending on its policy, either drops or holds the producer.
+// A stage whose consumer throws stops consuming and discards the rest of its
+// items; the other stages carry on and finish() reports the error.
+template <typename T>
+class Pipeline {
+public:
+    Pipeline() = default;
+    ~Pipeline() { join(); }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Register a consumer stage (before start)
+    void addStage(const std::string& name, std::function<void(const T&)> consume,
+                  std::size_t capacity = 4096, StagePolicy policy = StagePolicy::Block) {
+        stages_.push_back(std::make_unique<Stage>(name, std::move(consume), capacity, policy));
+    }
+
+    // Launch one thread per stage
+    void start() {
+        for (auto& s : stages_) s->thread = std::thread([st = s.get()] { st->run(); });
+    }
+
+    // Hand an item to every stage (producer thread only), then wake the parked ones
+    void push(const T& item) {
+        for (auto& s : stages_) s->offer(item);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        for (auto& s : stages_) s->wake();
+    }
+
+    // Let every stage drain its queue, then join the threads; throws the first
+    // stage failure once all of them are done
+    void finish() {
+        join();
+        for (const auto& s : stages_)
+            if (s->failed.load(std::memory_order_acquire))
+                throw std::runtime_error("Stage '" + s->name + "' failed: " + s->error);
+    }
+
+    std::vector<StageStats> stats() const {
+        std::vector<StageStats> out;
+        for (const auto& s : stages_) out.push_back(s->snapshot());
+        return out;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void join() {
+        for (auto& s : stages_) s->close();
+        for (auto& s : stages_)
+            if (s->thread.joinable()) s->thread.join();
+    }
+
+    struct Stage {
+        Stage(const std::string& n, std::function<void(const T&)> fn, std::size_t cap, StagePolicy p)
+            : name(n), consume(std::move(fn)), queue(cap), policy(p) {}
+
+        // Producer side
+        void offer(const T& item) {
+            if (failed.load(std::memory_order_relaxed)) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            if (!queue.tryPush(item)) {
+                if (policy == StagePolicy::Drop) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                auto t0 = Clock::now();
+                for (int spins = 0; !queue.tryPush(item); ++spins) backoff(spins);
+                blockedNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count(),
+                                    std::memory_order_relaxed);
+            }
+            std::size_t depth = queue.size();
+            if (depth > maxDepth.load(std::memory_order_relaxed)) maxDepth.store(depth, std::memory_order_relaxed);
+        }
+
+        // Notify a parked consumer (after a seq_cst fence). The fences on both sides
+        // order the queue index against parked: either the consumer sees the item or
+        // the producer sees it parked.
+        void wake() {
+            if (parked.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(parkMutex);
+                parkCv.notify_one();
+            }
+        }
+
+        void close() {
+            closed.store(true, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wake();
+        }
+
+        // Consumer thread: pop until closed and empty, backing off while idle. A
+        // throwing consumer marks the stage failed; later items are discarded so
+        // a blocking producer is never held up by a dead stage.
+        void run() {
+            T item;
+            int idle = 0;
+            while (true) {
+                if (queue.tryPop(item)) {
+                    idle = 0;
+                    if (failed.load(std::memory_order_relaxed)) {
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+                    auto t0 = Clock::now();
+                    try {
+                        consume(item);
+                    } catch (const std::exception& e) {
+                        fail(e.what());
+                    } catch (...) {
+                        fail("unknown exception");
+                    }
+                    busyNs.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - t0).count(),
+                                     std::memory_order_relaxed);
+                    processed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (closed.load(std::memory_order_acquire) && queue.size() == 0) break;
+                if (idle < kParkAfter) backoff(idle++);
+                else park();
+            }
+        }
+
+        // Sleep until the producer pushes or closes the stage
+        void park() {
+            std::unique_lock<std::mutex> lock(parkMutex);
+            parked.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            parkCv.wait(lock, [this] { return queue.size() != 0 || closed.load(std::memory_order_acquire); });
+            parked.store(false, std::memory_order_relaxed);
+        }
+
+        // error is written once, before failed is published
+        void fail(const std::string& what) {
+            error = what;
+            failed.store(true, std::memory_order_release);
+        }
+
+        // Idle rounds before the consumer parks: about 1 ms of short sleeps first,
+        // so a steady stream rarely needs a wakeup from the producer
+        static constexpr int kParkAfter = 128 + 20;
+
+        // Spin briefly, then yield, then sleep: no system calls on a busy path
+        static void backoff(int n) {
+            if (n < 64) return;
+            if (n < 128) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+
+        StageStats snapshot() const {
+            StageStats s;
+            s.name = name;
+            s.capacity = queue.capacity();
+            s.depth = queue.size();
+            s.maxDepth = maxDepth.load(std::memory_order_relaxed);
+            s.processed = processed.load(std::memory_order_relaxed);
+            s.dropped = dropped.load(std::memory_order_relaxed);
+            s.busySeconds = busyNs.load(std::memory_order_relaxed) * 1e-9;
+            s.blockedSeconds = blockedNs.load(std::memory_order_relaxed) * 1e-9;
+            if (failed.load(std::memory_order_acquire)) s.error = error;
+            return s;
+        }
+
+        std::string name;
+        std::function<void(const T&)> consume;
+        SpscQueue<T> queue;
+        StagePolicy policy;
+        std::thread thread;
+        std::atomic<bool> closed{false};
+        std::atomic<bool> parked{false};
+        std::mutex parkMutex;
+        std::condition_variable parkCv;
+        std::atomic<bool> failed{false};
+        std::string error;
+        std::atomic<std::size_t> maxDepth{0};
+        std::atomic<std::uint64_t> processed{0};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<std::int64_t> busyNs{0};
+        std::atomic<std::int64_t> blockedNs{0};
+    };
+
+    std::vector<std::unique_ptr<Stage>> stages_;
+};
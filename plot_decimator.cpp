@@ -0,0 +1,120 @@
+#include "plot_decimator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+MinMaxDecimator::MinMaxDecimator(std::size_t targetBuckets)
+    : target_(targetBuckets < 1 ? 1 : targetBuckets), count_(0), bucketSize_(1), partial_{}, partialCount_(0) {
+    buckets_.reserve(2 * target_);
+}
+
+std::uint64_t MinMaxDecimator::count() const {
+    return count_;
+}
+
+std::uint64_t MinMaxDecimator::bucketSize() const {
+    return bucketSize_;
+}
+
+void MinMaxDecimator::clear() {
+    count_ = 0;
+    bucketSize_ = 1;
+    buckets_.clear();
+    partialCount_ = 0;
+}
+
+// Update the open bucket; close it once it holds bucketSize_ points
+void MinMaxDecimator::add(double x, double y) {
+    Sample s{x, y, count_++};
+    if (partialCount_ == 0) {
+        partial_ = {s, s, s, s};
+    } else {
+        partial_.last = s;
+        if (y < partial_.min.y) partial_.min = s;
+        if (y > partial_.max.y) partial_.max = s;
+    }
+    if (++partialCount_ < bucketSize_) return;
+
+    buckets_.push_back(partial_);
+    partialCount_ = 0;
+    if (buckets_.size() == 2 * target_) collapse();
+}
+
+// Move one level up the pyramid: 2N buckets become N buckets of twice the size
+void MinMaxDecimator::collapse() {
+    std::size_t half = buckets_.size() / 2;
+    for (std::size_t i = 0; i < half; ++i) buckets_[i] = merge(buckets_[2 * i], buckets_[2 * i + 1]);
+    buckets_.resize(half);
+    bucketSize_ *= 2;
+}
+
+MinMaxDecimator::Bucket MinMaxDecimator::merge(const Bucket& a, const Bucket& b) {
+    return {a.first, b.last, b.min.y < a.min.y ? b.min : a.min, b.max.y > a.max.y ? b.max : a.max};
+}
+
+// First, min, max and last ordered by stream position, each at most once
+void MinMaxDecimator::emit(const Bucket& b, std::vector<PlotPoint>& out, std::uint32_t series) {
+    const Sample* s[4] = {&b.first, &b.min, &b.max, &b.last};
+    std::sort(s, s + 4, [](const Sample* l, const Sample* r) { return l->seq < r->seq; });
+    for (int i = 0; i < 4; ++i) {
+        if (i > 0 && s[i]->seq == s[i - 1]->seq) continue;
+        out.push_back({s[i]->x, s[i]->y, series});
+    }
+}
+
+void MinMaxDecimator::snapshot(std::vector<PlotPoint>& out, std::uint32_t series) const {
+    for (const Bucket& b : buckets_) emit(b, out, series);
+    if (partialCount_ > 0) emit(partial_, out, series);
+}
+
+// Each bucket picks the point forming the largest triangle with the previously
+// chosen point and the average of the next bucket
+std::vector<std::size_t> lttb(std::span<const double> x, std::span<const double> y, std::size_t threshold) {
+    if (x.size() != y.size()) throw std::invalid_argument("lttb: x and y differ in length");
+    std::size_t n = x.size();
+    std::vector<std::size_t> picked;
+    if (threshold >= n || threshold < 3) {
+        picked.resize(n);
+        for (std::size_t i = 0; i < n; ++i) picked[i] = i;
+        return picked;
+    }
+
+    picked.reserve(threshold);
+    picked.push_back(0);
+    double every = static_cast<double>(n - 2) / (threshold - 2);
+    std::size_t a = 0;
+    for (std::size_t b = 0; b < threshold - 2; ++b) {
+        // Average of the following bucket (the last point for the final bucket)
+        std::size_t nextStart = static_cast<std::size_t>((b + 1) * every) + 1;
+        std::size_t nextEnd = std::min(static_cast<std::size_t>((b + 2) * every) + 1, n);
+        double avgX = 0.0, avgY = 0.0;
+        if (nextStart >= nextEnd) {
+            avgX = x[n - 1];
+            avgY = y[n - 1];
+        } else {
+            for (std::size_t i = nextStart; i < nextEnd; ++i) {
+                avgX += x[i];
+                avgY += y[i];
+            }
+            avgX /= nextEnd - nextStart;
+            avgY /= nextEnd - nextStart;
+        }
+
+        std::size_t start = static_cast<std::size_t>(b * every) + 1;
+        std::size_t end = std::min(static_cast<std::size_t>((b + 1) * every) + 1, n - 1);
+        double ax = x[a], ay = y[a];
+        double best = -1.0;
+        std::size_t bestIndex = start;
+        for (std::size_t i = start; i < end; ++i) {
+            double area = std::fabs((ax - avgX) * (y[i] - ay) - (ax - x[i]) * (avgY - ay));
+            if (area > best) {
+                best = area;
+                bestIndex = i;
+            }
+        }
+        picked.push_back(bestIndex);
+        a = bestIndex;
+    }
+    picked.push_back(n - 1);
+    return picked;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// One sample for the live plot
+struct PlotPoint {
+    double x;              // Usually the measured voltage
+    double y;              // Usually the measured current
+    std::uint32_t series;  // Curve the point belongs to
+};
+
+// Streaming min/max decimation for plotting arbitrarily long point streams.
+//
+// Points are grouped in stream order into buckets of equal size. Each bucket
+// keeps its first, last, minimum and maximum point, which is enough to draw
+// the same polyline at screen resolution (M4 aggregation). The buckets form a
+// pyramid: once the level reaches 2 x targetBuckets, neighbouring buckets are
+// merged into the next coarser level and the bucket size doubles. Only the
+// coarsest level is kept, so memory is O(targetBuckets), adding a point is
+// amortized O(1), and a snapshot is at most 8 x targetBuckets points with
+// every visual extreme preserved.
+class MinMaxDecimator {
+public:
+    explicit MinMaxDecimator(std::size_t targetBuckets = 1000);
+
+    // Feed one point
+    void add(double x, double y);
+
+    // Points fed so far
+    std::uint64_t count() const;
+
+    // Raw points per complete bucket at the current level
+    std::uint64_t bucketSize() const;
+
+    // Append the decimated polyline (stream order, no duplicates) to out
+    void snapshot(std::vector<PlotPoint>& out, std::uint32_t series = 0) const;
+
+    // Forget all points
+    void clear();
+
+private:
+    // A point with its position in the stream
+    struct Sample {
+        double x;
+        double y;
+        std::uint64_t seq;
+    };
+
+    struct Bucket {
+        Sample first, last, min, max;
+    };
+
+    // Merge pairs of buckets into the next level
+    void collapse();
+
+    // Combine two neighbouring buckets
+    static Bucket merge(const Bucket& a, const Bucket& b);
+
+    // Emit a bucket's distinct points in stream order
+    static void emit(const Bucket& b, std::vector<PlotPoint>& out, std::uint32_t series);
+
+    std::size_t target_;
+    std::uint64_t count_;
+    std::uint64_t bucketSize_;
+    std::vector<Bucket> buckets_;   // Complete buckets of the current level
+    Bucket partial_;                // Bucket being filled
+    std::uint64_t partialCount_;
+};
+
+// Largest-Triangle-Three-Buckets downsampling of a complete series: returns the
+// indices of at most threshold points (always including the first and last)
+// that best preserve the visual shape. Intended for offline plots of stored runs.
+std::vector<std::size_t> lttb(std::span<const double> x, std::span<const double> y, std::size_t threshold);
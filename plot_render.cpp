@@ -0,0 +1,119 @@
+// Render run files to PNG plots without Python or a display.
+//
+// Usage: ./plot_render [--rv] [--width W] [--height H] [--out DIR] [-j N] RUN...
+//   --rv        Plot resistance instead of current against voltage
+//   --out DIR   Directory for the PNGs (default: next to each run file)
+//   -j N        Render N files in parallel (default: all cores)
+// Every RUN.run becomes RUN.png, with one curve per instrument in the file.
+#include "plot_renderer.hpp"
+#include "run_file.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Plot options shared by all files of a batch
+struct RenderJob {
+    bool rv = false;
+    int width = 800;
+    int height = 600;
+    std::string outDir;
+};
+
+// Render one run file; the mapping serves the columns directly when there is one instrument
+static void renderRun(const std::string& path, const RenderJob& job) {
+    RunFileReader run(path);
+    RunColumns c = run.columns();
+    std::span<const double> y = job.rv ? c.resistance : c.current;
+
+    PlotOptions opt;
+    opt.width = job.width;
+    opt.height = job.height;
+    opt.title = std::filesystem::path(path).stem().string();
+    opt.yLabel = job.rv ? "Resistance (Ohm)" : "Current (A)";
+
+    auto name = [&](std::uint32_t i) {
+        return i < c.instruments.size() ? c.instruments[i].model + " " + c.instruments[i].serial : "";
+    };
+
+    std::vector<PlotSeries> series;
+    std::map<std::uint32_t, std::pair<std::vector<double>, std::vector<double>>> split;
+    bool single = std::all_of(c.instrument.begin(), c.instrument.end(),
+                              [&](std::uint32_t i) { return i == c.instrument.front(); });
+    if (single) {
+        series.push_back({c.instrument.empty() ? "" : name(c.instrument.front()), c.voltage, y});
+        if (c.instruments.size() <= 1) series.back().name.clear();
+    } else {
+        for (std::size_t i = 0; i < c.voltage.size(); ++i) {
+            auto& [xs, ys] = split[c.instrument[i]];
+            xs.push_back(c.voltage[i]);
+            ys.push_back(y[i]);
+        }
+        for (auto& [inst, xy] : split) series.push_back({name(inst), xy.first, xy.second});
+    }
+
+    std::filesystem::path out = std::filesystem::path(path).replace_extension(".png");
+    if (!job.outDir.empty()) out = std::filesystem::path(job.outDir) / out.filename();
+    renderPlotPng(out.string(), series, opt);
+}
+
+int main(int argc, char** argv) {
+    RenderJob job;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opt = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << opt << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (opt == "--rv") job.rv = true;
+        else if (opt == "--width") job.width = std::stoi(value());
+        else if (opt == "--height") job.height = std::stoi(value());
+        else if (opt == "--out") job.outDir = value();
+        else if (opt == "-j") threads = std::max(1, std::stoi(value()));
+        else if (!opt.empty() && opt[0] == '-') {
+            std::cerr << "Unknown option: " << opt << "\n";
+            return 2;
+        } else files.push_back(opt);
+    }
+    if (files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--rv] [--width W] [--height H] [--out DIR] [-j N] RUN...\n";
+        return 2;
+    }
+    if (!job.outDir.empty()) std::filesystem::create_directories(job.outDir);
+
+    // Workers pull the next file index until all are done
+    std::atomic<std::size_t> next{0};
+    std::atomic<int> failed{0};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < std::min<std::size_t>(threads, files.size()); ++t) {
+        pool.emplace_back([&] {
+            for (std::size_t i; (i = next++) < files.size();) {
+                try {
+                    renderRun(files[i], job);
+                } catch (const std::exception& e) {
+                    std::fprintf(stderr, "[!] %s: %s\n", files[i].c_str(), e.what());
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (auto& t : pool) t.join();
+
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "[✓] %zu plot(s) in %.2f s (%.0f per minute)\n", files.size() - failed, sec,
+                 (files.size() - failed) / sec * 60.0);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,327 @@
+#include "plot_renderer.hpp"
+#include "plot_decimator.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace {
+
+// Classic 5x7 font for ASCII 32..126: five column bytes per glyph, bit 0 is the top row
+const std::uint8_t kFont[95][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x14, 0x08, 0x3E, 0x08, 0x14}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00},
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E},
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x09, 0x01},
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x3F, 0x40, 0x38, 0x40, 0x3F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x07, 0x08, 0x70, 0x08, 0x07}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x7F, 0x41, 0x41, 0x00},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x00, 0x41, 0x41, 0x7F, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x0C, 0x52, 0x52, 0x52, 0x3E},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00},
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08},
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x08, 0x04, 0x08, 0x10, 0x08},
+};
+
+const int kGlyphAdvance = 6;   // 5 columns plus 1 column of spacing
+const int kGlyphRows = 7;
+const int kSeriesColors = 10;
+
+const std::uint8_t* glyph(char c) {
+    if (c < 32 || c > 126) c = '?';
+    return kFont[c - 32];
+}
+
+// Step of about target ticks over range, rounded to 1, 2 or 5 x 10^k
+double niceStep(double range, int target) {
+    double raw = range / target;
+    double mag = std::pow(10.0, std::floor(std::log10(raw)));
+    double norm = raw / mag;
+    return (norm < 1.5 ? 1.0 : norm < 3.0 ? 2.0 : norm < 7.0 ? 5.0 : 10.0) * mag;
+}
+
+std::string tickLabel(double v, double step) {
+    if (std::fabs(v) < step * 1e-6) v = 0.0;
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.4g", v);
+    return buf;
+}
+
+// Finite min/max over all series, padded; never an empty range
+void dataRange(const std::vector<PlotSeries>& series, bool useX, double& lo, double& hi) {
+    lo = std::numeric_limits<double>::infinity();
+    hi = -lo;
+    for (const auto& s : series) {
+        for (double v : useX ? s.x : s.y) {
+            if (!std::isfinite(v)) continue;
+            lo = std::min(lo, v);
+            hi = std::max(hi, v);
+        }
+    }
+    if (!std::isfinite(lo)) {
+        lo = 0.0;
+        hi = 1.0;
+    } else if (hi - lo <= std::fabs(hi) * 1e-12) {
+        double pad = lo != 0.0 ? std::fabs(lo) * 0.1 : 1.0;
+        lo -= pad;
+        hi += pad;
+    } else {
+        double pad = (hi - lo) * 0.03;
+        lo -= pad;
+        hi += pad;
+    }
+}
+
+// Liang-Barsky clip of a segment to [x0, x1] x [y0, y1]; false if nothing is left
+bool clip(double& ax, double& ay, double& bx, double& by, double x0, double y0, double x1, double y1) {
+    double t0 = 0.0, t1 = 1.0;
+    double dx = bx - ax, dy = by - ay;
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {ax - x0, x1 - ax, ay - y0, y1 - ay};
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0) return false;
+            continue;
+        }
+        double t = q[i] / p[i];
+        if (p[i] < 0.0) t0 = std::max(t0, t);
+        else t1 = std::min(t1, t);
+        if (t0 > t1) return false;
+    }
+    bx = ax + t1 * dx;
+    by = ay + t1 * dy;
+    ax += t0 * dx;
+    ay += t0 * dy;
+    return true;
+}
+
+} // namespace
+
+const std::vector<PngColor>& plotPalette() {
+    static const std::vector<PngColor> palette = {
+        {255, 255, 255}, {0, 0, 0},       {225, 225, 225}, {150, 150, 150},
+        {31, 119, 180},  {255, 127, 14},  {44, 160, 44},   {214, 39, 40},   {148, 103, 189},
+        {140, 86, 75},   {227, 119, 194}, {127, 127, 127}, {188, 189, 34},  {23, 190, 207},
+    };
+    return palette;
+}
+
+Canvas::Canvas(int width, int height, std::uint8_t background)
+    : width_(width), height_(height), pixels_(static_cast<std::size_t>(width) * height, background) {}
+
+int Canvas::width() const {
+    return width_;
+}
+
+int Canvas::height() const {
+    return height_;
+}
+
+const std::vector<std::uint8_t>& Canvas::pixels() const {
+    return pixels_;
+}
+
+void Canvas::set(int x, int y, std::uint8_t color) {
+    if (x < 0 || y < 0 || x >= width_ || y >= height_) return;
+    pixels_[static_cast<std::size_t>(y) * width_ + x] = color;
+}
+
+void Canvas::fillRect(int x, int y, int w, int h, std::uint8_t color) {
+    int xa = std::max(x, 0), xb = std::min(x + w, width_);
+    int ya = std::max(y, 0), yb = std::min(y + h, height_);
+    for (int row = ya; row < yb; ++row)
+        std::fill(pixels_.begin() + static_cast<std::size_t>(row) * width_ + xa,
+                  pixels_.begin() + static_cast<std::size_t>(row) * width_ + std::max(xa, xb), color);
+}
+
+void Canvas::rect(int x, int y, int w, int h, std::uint8_t color) {
+    fillRect(x, y, w, 1, color);
+    fillRect(x, y + h - 1, w, 1, color);
+    fillRect(x, y, 1, h, color);
+    fillRect(x + w - 1, y, 1, h, color);
+}
+
+// Bresenham; the second pixel of a thick line goes across the major direction
+void Canvas::line(int x0, int y0, int x1, int y1, std::uint8_t color, int thickness) {
+    int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+    int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+    bool steep = -dy > dx;
+    int err = dx + dy;
+    while (true) {
+        set(x0, y0, color);
+        if (thickness > 1) steep ? set(x0 + 1, y0, color) : set(x0, y0 + 1, color);
+        if (x0 == x1 && y0 == y1) break;
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+void Canvas::text(int x, int y, const std::string& s, std::uint8_t color, int scale) {
+    for (char c : s) {
+        const std::uint8_t* g = glyph(c);
+        for (int col = 0; col < 5; ++col)
+            for (int row = 0; row < kGlyphRows; ++row)
+                if (g[col] & (1 << row)) fillRect(x + col * scale, y + row * scale, scale, scale, color);
+        x += kGlyphAdvance * scale;
+    }
+}
+
+// Glyphs rotated a quarter turn counter-clockwise, baseline on the left
+void Canvas::textVertical(int x, int y, const std::string& s, std::uint8_t color, int scale) {
+    for (char c : s) {
+        const std::uint8_t* g = glyph(c);
+        for (int col = 0; col < 5; ++col)
+            for (int row = 0; row < kGlyphRows; ++row)
+                if (g[col] & (1 << row)) fillRect(x + row * scale, y - (col + 1) * scale, scale, scale, color);
+        y -= kGlyphAdvance * scale;
+    }
+}
+
+int Canvas::textWidth(const std::string& s, int scale) {
+    return s.empty() ? 0 : (static_cast<int>(s.size()) * kGlyphAdvance - 1) * scale;
+}
+
+int Canvas::textHeight(int scale) {
+    return kGlyphRows * scale;
+}
+
+Canvas renderPlot(const std::vector<PlotSeries>& series, const PlotOptions& options) {
+    Canvas c(options.width, options.height);
+
+    double xmin, xmax, ymin, ymax;
+    dataRange(series, true, xmin, xmax);
+    dataRange(series, false, ymin, ymax);
+    double xstep = niceStep(xmax - xmin, 8);
+    double ystep = niceStep(ymax - ymin, 6);
+
+    // Left margin fits the widest y tick label
+    auto ticks = [](double lo, double hi, double step) {
+        std::vector<double> t;
+        for (double k = std::ceil(lo / step); k * step <= hi; ++k) t.push_back(k * step);
+        return t;
+    };
+    std::vector<double> xticks = ticks(xmin, xmax, xstep);
+    std::vector<double> yticks = ticks(ymin, ymax, ystep);
+    int labelWidth = 0;
+    for (double v : yticks) labelWidth = std::max(labelWidth, Canvas::textWidth(tickLabel(v, ystep)));
+    int left = 24 + labelWidth + 8;
+    int top = options.title.empty() ? 16 : 36;
+    int right = options.width - 16;
+    int bottom = options.height - 44;
+    if (right - left < 10 || bottom - top < 10) return c;
+
+    auto px = [&](double x) { return left + (x - xmin) / (xmax - xmin) * (right - left); };
+    auto py = [&](double y) { return bottom - (y - ymin) / (ymax - ymin) * (bottom - top); };
+
+    // Grid, ticks and tick labels
+    for (double v : xticks) {
+        int x = static_cast<int>(std::lround(px(v)));
+        c.fillRect(x, top, 1, bottom - top, PlotGrid);
+        c.fillRect(x, bottom, 1, 5, PlotInk);
+        std::string label = tickLabel(v, xstep);
+        c.text(x - Canvas::textWidth(label) / 2, bottom + 8, label, PlotInk);
+    }
+    for (double v : yticks) {
+        int y = static_cast<int>(std::lround(py(v)));
+        c.fillRect(left, y, right - left, 1, PlotGrid);
+        c.fillRect(left - 5, y, 5, 1, PlotInk);
+        std::string label = tickLabel(v, ystep);
+        c.text(left - 8 - Canvas::textWidth(label), y - 3, label, PlotInk);
+    }
+    c.rect(left, top, right - left + 1, bottom - top + 1, PlotInk);
+
+    // Title and axis labels
+    if (!options.title.empty())
+        c.text((options.width - Canvas::textWidth(options.title, 2)) / 2, 10, options.title, PlotInk, 2);
+    c.text((left + right - Canvas::textWidth(options.xLabel)) / 2, bottom + 26, options.xLabel, PlotInk);
+    c.textVertical(6, (top + bottom + Canvas::textWidth(options.yLabel)) / 2, options.yLabel, PlotInk);
+
+    // Series: very long ones are reduced to a min/max envelope at pixel resolution first
+    std::vector<PlotPoint> reduced;
+    for (std::size_t si = 0; si < series.size(); ++si) {
+        const PlotSeries& s = series[si];
+        std::uint8_t color = PlotSeriesBase + si % kSeriesColors;
+        std::size_t n = std::min(s.x.size(), s.y.size());
+
+        reduced.clear();
+        if (n > static_cast<std::size_t>(4 * (right - left))) {
+            MinMaxDecimator dec((right - left) / 2);
+            for (std::size_t i = 0; i < n; ++i) dec.add(s.x[i], s.y[i]);
+            dec.snapshot(reduced);
+        } else {
+            reduced.reserve(n);
+            for (std::size_t i = 0; i < n; ++i) reduced.push_back({s.x[i], s.y[i], 0});
+        }
+
+        bool havePrev = false;
+        double prevX = 0.0, prevY = 0.0;
+        for (const PlotPoint& p : reduced) {
+            if (!std::isfinite(p.x) || !std::isfinite(p.y)) {
+                havePrev = false;
+                continue;
+            }
+            double x = px(p.x), y = py(p.y);
+            if (havePrev) {
+                double ax = prevX, ay = prevY, bx = x, by = y;
+                if (clip(ax, ay, bx, by, left, top, right, bottom))
+                    c.line(static_cast<int>(std::lround(ax)), static_cast<int>(std::lround(ay)),
+                           static_cast<int>(std::lround(bx)), static_cast<int>(std::lround(by)), color, 2);
+            }
+            // Markers while points are still far apart
+            if (n <= 100) c.fillRect(static_cast<int>(std::lround(x)) - 2, static_cast<int>(std::lround(y)) - 2, 5, 5, color);
+            prevX = x;
+            prevY = y;
+            havePrev = true;
+        }
+    }
+
+    // Legend in the top right corner of the plot area
+    bool named = std::any_of(series.begin(), series.end(), [](const PlotSeries& s) { return !s.name.empty(); });
+    if (series.size() > 1 || (named && series.size() == 1)) {
+        int w = 0;
+        for (const auto& s : series) w = std::max(w, Canvas::textWidth(s.name));
+        int boxW = w + 34, boxH = static_cast<int>(series.size()) * 12 + 6;
+        int bx = right - boxW - 6, by = top + 6;
+        c.fillRect(bx, by, boxW, boxH, PlotBackground);
+        c.rect(bx, by, boxW, boxH, PlotFrame);
+        for (std::size_t si = 0; si < series.size(); ++si) {
+            int y = by + 6 + static_cast<int>(si) * 12;
+            std::uint8_t color = PlotSeriesBase + si % kSeriesColors;
+            c.fillRect(bx + 6, y + 2, 16, 3, color);
+            c.text(bx + 28, y, series[si].name, PlotInk);
+        }
+    }
+    return c;
+}
+
+void renderPlotPng(const std::string& path, const std::vector<PlotSeries>& series, const PlotOptions& options) {
+    Canvas c = renderPlot(series, options);
+    writePng(path, c.width(), c.height(), plotPalette(), c.pixels());
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "png_writer.hpp"
+
+// One curve of a plot; x and y must have the same length (non-finite values break the line)
+struct PlotSeries {
+    std::string name;
+    std::span<const double> x;
+    std::span<const double> y;
+};
+
+// Size and labels of a rendered plot
+struct PlotOptions {
+    int width = 800;
+    int height = 600;
+    std::string title;
+    std::string xLabel = "Voltage (V)";
+    std::string yLabel = "Current (A)";
+};
+
+// Palette indices used by the renderer (see plotPalette)
+enum PlotColor : std::uint8_t {
+    PlotBackground = 0,
+    PlotInk = 1,          // Axes, ticks and text
+    PlotGrid = 2,
+    PlotFrame = 3,        // Legend box
+    PlotSeriesBase = 4    // First of the series colors
+};
+
+// Palette shared by all rendered plots: fixed colors, then one color per series
+const std::vector<PngColor>& plotPalette();
+
+// Palette-indexed raster with the drawing primitives the plot renderer needs
+class Canvas {
+public:
+    Canvas(int width, int height, std::uint8_t background = PlotBackground);
+
+    int width() const;
+    int height() const;
+    const std::vector<std::uint8_t>& pixels() const;
+
+    // Set one pixel (ignored outside the canvas)
+    void set(int x, int y, std::uint8_t color);
+
+    void fillRect(int x, int y, int w, int h, std::uint8_t color);
+    void rect(int x, int y, int w, int h, std::uint8_t color);
+
+    // Line between pixel centers, 1 or 2 pixels thick
+    void line(int x0, int y0, int x1, int y1, std::uint8_t color, int thickness = 1);
+
+    // 5x7 bitmap text, top-left at (x, y); vertical text runs bottom to top from (x, y)
+    void text(int x, int y, const std::string& s, std::uint8_t color, int scale = 1);
+    void textVertical(int x, int y, const std::string& s, std::uint8_t color, int scale = 1);
+
+    static int textWidth(const std::string& s, int scale = 1);
+    static int textHeight(int scale = 1);
+
+private:
+    int width_;
+    int height_;
+    std::vector<std::uint8_t> pixels_;
+};
+
+// Rasterize an XY plot with axes, ticks, grid, labels and a legend for several series
+Canvas renderPlot(const std::vector<PlotSeries>& series, const PlotOptions& options);
+
+// Render and save as PNG
+void renderPlotPng(const std::string& path, const std::vector<PlotSeries>& series, const PlotOptions& options);
@@ -3,21 +3,33 @@ import matplotlib.animation as animation
 import sys
 import os
 import select
+import struct
 
-# Buffers to store measurement data
-xdata, ydata = [], []
+# Frame layout written by PyPlotter (native byte order):
+# header  uint32 magic 'CPLT', uint16 type, uint16 reserved, uint32 count, uint32 dropped
+# record  double x, double y, uint32 series, uint32 reserved
+FRAME_HEADER = struct.Struct("=IHHII")
+FRAME_RECORD = struct.Struct("=ddII")
+FRAME_MAGIC = 0x544C5043
+FRAME_STOP = 2
+FRAME_SNAPSHOT = 3  # Replaces the series it contains (decimated view)
+
+# Buffers to store measurement data, one (x, y) list pair per series
+series_data = {}
+rx_buffer = bytearray()
+dropped_total = 0
 stop_flag = False   # Used to stop plotting loop
 finished = False    # Used to avoid redundant operations after finish
 
 # Create plot figure and axis
 fig, ax = plt.subplots()
-line, = ax.plot([], [], lw=2)  # Line object for real-time updating
+lines = {}          # Line object per series for real-time updating
 
 # Initialization function for animation
 def init():
-    ax.set_xlim(0, 100)       # Initial x-axis range
+    ax.set_xlim(0, 1)         # Initial x-axis range
     ax.set_ylim(-1, 1)        # Initial y-axis range
-    return line,
+    return []
 
 # Generate a new file name avoiding overwrites
 def get_next_filename(folder, base, ext):
@@ -30,42 +42,75 @@ def get_next_filename(folder, base, ext):
             return path
         i += 1
 
-# Read a single line from stdin if available
-def read_stdin_line():
-    if select.select([sys.stdin], [], [], 0.01)[0]:
-        return sys.stdin.readline()
-    return None
+# Read everything currently available on stdin (b"" once the writer has closed it)
+def read_stdin_bytes():
+    chunks = []
+    while select.select([sys.stdin], [], [], 0)[0]:
+        chunk = os.read(sys.stdin.fileno(), 1 << 16)
+        if not chunk:
+            return b"".join(chunks)
+        chunks.append(chunk)
+    return b"".join(chunks) if chunks else None
+
+# Decode all complete frames in the buffer, keep a partial frame for the next call
+def decode_frames():
+    global stop_flag, dropped_total
+    pos = 0
+    while len(rx_buffer) - pos >= FRAME_HEADER.size:
+        magic, ftype, _, count, dropped = FRAME_HEADER.unpack_from(rx_buffer, pos)
+        if magic != FRAME_MAGIC:
+            print("Plot stream out of sync, stopping")
+            stop_flag = True
+            break
+        size = FRAME_HEADER.size + count * FRAME_RECORD.size
+        if len(rx_buffer) - pos < size:
+            break
+        dropped_total += dropped
+        records = memoryview(rx_buffer)[pos + FRAME_HEADER.size:pos + size]
+        replaced = set()
+        for x, y, series, _ in FRAME_RECORD.iter_unpack(records):
+            if ftype == FRAME_SNAPSHOT and series not in replaced:
+                series_data[series] = ([], [])
+                replaced.add(series)
+            xs, ys = series_data.setdefault(series, ([], []))
+            xs.append(x)
+            ys.append(y)
+        records.release()
+        pos += size
+        if ftype == FRAME_STOP:
+            stop_flag = True
+            break
+    del rx_buffer[:pos]
 
 # Animation frame update function
 def update(frame):
     global stop_flag, finished
     if finished:
-        return line,
+        return list(lines.values())
 
-    while True:
-        line_in = read_stdin_line()
-        if line_in is None:
-            break
-        line_in = line_in.strip()
-        if line_in == "STOP":
-            stop_flag = True
-            break
-        try:
-            # Parse and store numeric input
-            y = float(line_in)
-            xdata.append(len(xdata))
-            ydata.append(y)
-            print(f"Plotting {len(xdata)} → {y:.3f}")
-        except ValueError:
-            pass
+    data = read_stdin_bytes()
+    if data:
+        rx_buffer.extend(data)
+        decode_frames()
+    if data == b"":
+        stop_flag = True    # Writer went away without a stop frame
 
     # Update plot with new data
-    if xdata:
-        line.set_data(xdata, ydata)
-        ax.set_xlim(max(0, len(xdata) - 100), len(xdata))
-        ymin = min(ydata[-100:])
-        ymax = max(ydata[-100:])
-        ax.set_ylim(ymin - 0.1, ymax + 0.1)
+    for series, (xs, ys) in series_data.items():
+        if series not in lines:
+            lines[series], = ax.plot([], [], lw=2, marker=".", label=f"Series {series}")
+            if len(series_data) > 1:
+                ax.legend()
+        lines[series].set_data(xs, ys)
+    if series_data:
+        xs_all = [x for xs, _ in series_data.values() for x in xs]
+        ys_all = [y for _, ys in series_data.values() for y in ys]
+        xpad = (max(xs_all) - min(xs_all)) * 0.05 or 0.1
+        ypad = (max(ys_all) - min(ys_all)) * 0.05 or abs(ys_all[0]) * 0.1 or 0.1
+        ax.set_xlim(min(xs_all) - xpad, max(xs_all) + xpad)
+        ax.set_ylim(min(ys_all) - ypad, max(ys_all) + ypad)
+    if dropped_total:
+        ax.set_title(f"Live Measurement Plot ({dropped_total} points dropped)")
 
     # Save final plot if stop flag is triggered
     if stop_flag and plt.fignum_exists(fig.number):
@@ -80,7 +125,7 @@ def update(frame):
             print("Close fallback:", e)
         finished = True
 
-    return line,
+    return list(lines.values())
 
 # Launch animation loop (200 ms interval)
 ani = animation.FuncAnimation(
@@ -92,8 +137,8 @@ ani = animation.FuncAnimation(
 
 # Plot styling
 plt.title("Live Measurement Plot")
-plt.xlabel("Point Index")
-plt.ylabel("Value")
+plt.xlabel("Voltage (V)")
+plt.ylabel("Current (A)")
 plt.grid(True)
 
 # Show plot window
@@ -101,4 +146,3 @@ try:
     plt.show()
 except KeyboardInterrupt:
     print("Plot interrupted by user.")
-
@@ -0,0 +1,205 @@
+#include "png_writer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+// Deflate length codes 257..285: base length and extra bits
+const std::uint16_t kLengthBase[29] = {3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                       31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+const std::uint8_t kLengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                       2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Deflate distance codes 0..29: base distance and extra bits
+const std::uint16_t kDistBase[30] = {1,    2,    3,    4,    5,    7,     9,     13,    17,  25,
+                                     33,   49,   65,   97,   129,  193,   257,   385,   513, 769,
+                                     1025, 1537, 2049, 3073, 4097, 6145,  8193,  12289, 16385, 24577};
+const std::uint8_t kDistExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                     6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+const std::size_t kWindow = 32768;
+const std::size_t kMinMatch = 3;
+const std::size_t kMaxMatch = 258;
+const int kHashBits = 15;
+const int kMaxChain = 16;
+
+// LSB-first bit packer for the deflate stream
+class BitWriter {
+public:
+    explicit BitWriter(std::string& out) : out_(out), acc_(0), bits_(0) {}
+
+    void put(std::uint32_t value, int n) {
+        acc_ |= static_cast<std::uint64_t>(value) << bits_;
+        bits_ += n;
+        while (bits_ >= 8) {
+            out_.push_back(static_cast<char>(acc_ & 0xFF));
+            acc_ >>= 8;
+            bits_ -= 8;
+        }
+    }
+
+    // Huffman codes are defined MSB-first, so they go out bit-reversed
+    void putCode(std::uint32_t code, int n) {
+        std::uint32_t rev = 0;
+        for (int i = 0; i < n; ++i) rev |= ((code >> i) & 1u) << (n - 1 - i);
+        put(rev, n);
+    }
+
+    void flush() {
+        if (bits_ > 0) out_.push_back(static_cast<char>(acc_ & 0xFF));
+        acc_ = 0;
+        bits_ = 0;
+    }
+
+private:
+    std::string& out_;
+    std::uint64_t acc_;
+    int bits_;
+};
+
+// Fixed Huffman literal/length code (RFC 1951, 3.2.6)
+void putLiteral(BitWriter& bw, unsigned sym) {
+    if (sym < 144) bw.putCode(0x30 + sym, 8);
+    else if (sym < 256) bw.putCode(0x190 + sym - 144, 9);
+    else if (sym < 280) bw.putCode(sym - 256, 7);
+    else bw.putCode(0xC0 + sym - 280, 8);
+}
+
+void putMatch(BitWriter& bw, std::size_t length, std::size_t distance) {
+    int lc = 28;
+    while (kLengthBase[lc] > length) --lc;
+    putLiteral(bw, 257 + lc);
+    if (kLengthExtra[lc]) bw.put(static_cast<std::uint32_t>(length - kLengthBase[lc]), kLengthExtra[lc]);
+
+    int dc = 29;
+    while (kDistBase[dc] > distance) --dc;
+    bw.putCode(dc, 5);
+    if (kDistExtra[dc]) bw.put(static_cast<std::uint32_t>(distance - kDistBase[dc]), kDistExtra[dc]);
+}
+
+std::uint32_t hash3(const std::uint8_t* p) {
+    std::uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - kHashBits);
+}
+
+// Big-endian 32-bit value as PNG and zlib store it
+void putBE32(std::string& out, std::uint32_t v) {
+    out.push_back(static_cast<char>(v >> 24));
+    out.push_back(static_cast<char>(v >> 16));
+    out.push_back(static_cast<char>(v >> 8));
+    out.push_back(static_cast<char>(v));
+}
+
+// Length, type, data and CRC of one PNG chunk
+void putChunk(std::string& png, const char type[4], const std::string& data) {
+    putBE32(png, static_cast<std::uint32_t>(data.size()));
+    std::string body(type, 4);
+    body += data;
+    png += body;
+    putBE32(png, crc32(reinterpret_cast<const std::uint8_t*>(body.data()), body.size()));
+}
+
+} // namespace
+
+// One final fixed-Huffman block; greedy LZ77 over hash chains
+std::string zlibCompress(const std::uint8_t* data, std::size_t size) {
+    std::string out;
+    out.reserve(size / 8 + 64);
+    out.push_back(0x78);  // CMF: deflate, 32 KB window
+    out.push_back(0x01);  // FLG: no dictionary, check bits
+
+    BitWriter bw(out);
+    bw.put(1, 1);  // BFINAL
+    bw.put(1, 2);  // BTYPE = fixed Huffman
+
+    std::vector<std::int32_t> head(1u << kHashBits, -1);
+    std::vector<std::int32_t> prev(size, -1);
+    auto insert = [&](std::size_t pos) {
+        if (pos + kMinMatch > size) return;
+        std::uint32_t h = hash3(data + pos);
+        prev[pos] = head[h];
+        head[h] = static_cast<std::int32_t>(pos);
+    };
+
+    std::size_t i = 0;
+    while (i < size) {
+        std::size_t bestLen = 0, bestDist = 0;
+        if (i + kMinMatch <= size) {
+            std::size_t limit = std::min(kMaxMatch, size - i);
+            std::int32_t cand = head[hash3(data + i)];
+            for (int chain = 0; cand >= 0 && chain < kMaxChain; ++chain, cand = prev[cand]) {
+                std::size_t dist = i - static_cast<std::size_t>(cand);
+                if (dist > kWindow) break;
+                const std::uint8_t* a = data + cand;
+                const std::uint8_t* b = data + i;
+                if (a[bestLen] != b[bestLen]) continue;
+                std::size_t len = 0;
+                while (len < limit && a[len] == b[len]) ++len;
+                if (len > bestLen) {
+                    bestLen = len;
+                    bestDist = dist;
+                    if (len == limit) break;
+                }
+            }
+        }
+
+        if (bestLen >= kMinMatch) {
+            putMatch(bw, bestLen, bestDist);
+            for (std::size_t k = 0; k < bestLen; ++k) insert(i + k);
+            i += bestLen;
+        } else {
+            putLiteral(bw, data[i]);
+            insert(i);
+            ++i;
+        }
+    }
+    putLiteral(bw, 256);  // End of block
+    bw.flush();
+
+    putBE32(out, adler32(data, size));
+    return out;
+}
+
+// Filter type 0 on every row (recommended for palette images)
+std::string encodePng(int width, int height, const std::vector<PngColor>& palette,
+                      const std::vector<std::uint8_t>& pixels) {
+    if (width <= 0 || height <= 0 || pixels.size() != static_cast<std::size_t>(width) * height)
+        throw std::invalid_argument("PNG size does not match pixel data");
+    if (palette.empty() || palette.size() > 256) throw std::invalid_argument("PNG palette needs 1..256 colors");
+
+    std::vector<std::uint8_t> raw(static_cast<std::size_t>(width + 1) * height);
+    for (int y = 0; y < height; ++y) {
+        raw[static_cast<std::size_t>(y) * (width + 1)] = 0;
+        std::memcpy(&raw[static_cast<std::size_t>(y) * (width + 1) + 1], &pixels[static_cast<std::size_t>(y) * width],
+                    width);
+    }
+
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+
+    std::string ihdr;
+    putBE32(ihdr, width);
+    putBE32(ihdr, height);
+    ihdr += std::string("\x08\x03\x00\x00\x00", 5);  // 8-bit indexed, deflate, adaptive filter, no interlace
+    putChunk(png, "IHDR", ihdr);
+
+    std::string plte;
+    for (const auto& c : palette) {
+        plte.push_back(static_cast<char>(c.r));
+        plte.push_back(static_cast<char>(c.g));
+        plte.push_back(static_cast<char>(c.b));
+    }
+    putChunk(png, "PLTE", plte);
+    putChunk(png, "IDAT", zlibCompress(raw.data(), raw.size()));
+    putChunk(png, "IEND", "");
+    return png;
+}
+
+void writePng(const std::string& path, int width, int height, const std::vector<PngColor>& palette,
+              const std::vector<std::uint8_t>& pixels) {
+    std::string png = encodePng(width, height, palette, pixels);
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(png.data(), static_cast<std::streamsize>(png.size())))
+        throw std::runtime_error("Failed to write " + path);
+}
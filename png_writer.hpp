@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "checksum.hpp"
+
+// RGB palette entry
+struct PngColor {
+    std::uint8_t r, g, b;
+};
+
+// Self-contained PNG encoder for 8-bit palette images (no zlib dependency).
+// Pixel data is compressed with a single fixed-Huffman deflate block using
+// greedy LZ77 matching, which suits plots: long runs of background and rows
+// that repeat the previous row compress to a few bits each.
+
+// Encode width x height palette indices (row-major) into a complete PNG file
+std::string encodePng(int width, int height, const std::vector<PngColor>& palette,
+                      const std::vector<std::uint8_t>& pixels);
+
+// Encode and write to path (throws on I/O failure)
+void writePng(const std::string& path, int width, int height, const std::vector<PngColor>& palette,
+              const std::vector<std::uint8_t>& pixels);
+
+// zlib stream (RFC 1950) of data using fixed-Huffman deflate
+std::string zlibCompress(const std::uint8_t* data, std::size_t size);
+
@@ -0,0 +1,109 @@
+#include "profiler.hpp"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+// Meyers singleton shared by all modules
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : enabled_(false), trace_(false), origin_(nowNs()) {}
+
+// steady_clock is monotonic and cheap on Linux (vDSO)
+std::int64_t Profiler::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Switch collection on or off
+void Profiler::enable(bool on, bool trace) {
+    trace_ = on && trace;
+    enabled_ = on;
+}
+
+// Fold one occurrence into the phase totals (and the trace if requested)
+void Profiler::record(const char* phase, std::int64_t startNs, std::int64_t durationNs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    PhaseStats& s = phases_[phase];
+    ++s.count;
+    s.totalNs += durationNs;
+    if (durationNs < s.minNs) s.minNs = durationNs;
+    if (durationNs > s.maxNs) s.maxNs = durationNs;
+    if (trace_) {
+        auto tid = static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        events_.push_back({phase, startNs, durationNs, tid});
+    }
+}
+
+// Add to a counter
+void Profiler::count(const char* counter, std::int64_t delta) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    counters_[counter] += delta;
+}
+
+std::map<std::string, PhaseStats> Profiler::phases() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return phases_;
+}
+
+std::map<std::string, std::int64_t> Profiler::counters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
+
+// Print one row per phase; share is relative to the time since reset()
+void Profiler::writeSummary(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double runMs = (nowNs() - origin_) / 1e6;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-28s %10s %12s %10s %10s %10s %7s\n",
+                  "phase", "count", "total ms", "mean us", "min us", "max us", "share");
+    out << line;
+    for (const auto& [name, s] : phases_) {
+        double totalMs = s.totalNs / 1e6;
+        std::snprintf(line, sizeof(line), "%-28s %10llu %12.3f %10.2f %10.2f %10.2f %6.1f%%\n",
+                      name.c_str(), static_cast<unsigned long long>(s.count), totalMs,
+                      s.totalNs / 1e3 / s.count, s.minNs / 1e3, s.maxNs / 1e3,
+                      runMs > 0 ? 100.0 * totalMs / runMs : 0.0);
+        out << line;
+    }
+    for (const auto& [name, value] : counters_) {
+        std::snprintf(line, sizeof(line), "%-28s %10lld\n", name.c_str(), static_cast<long long>(value));
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "run time %.3f ms\n", runMs);
+    out << line;
+}
+
+// Complete ("X") events with microsecond timestamps
+void Profiler::writeChromeTrace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to write trace: " + path);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    out << "{\"traceEvents\":[\n";
+    char line[256];
+    for (std::size_t i = 0; i < events_.size(); ++i) {
+        const Event& e = events_[i];
+        std::snprintf(line, sizeof(line),
+                      "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}%s\n",
+                      e.name, (e.startNs - origin_) / 1e3, e.durationNs / 1e3, e.tid,
+                      i + 1 < events_.size() ? "," : "");
+        out << line;
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+// Start a fresh run
+void Profiler::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phases_.clear();
+    counters_.clear();
+    events_.clear();
+    origin_ = nowNs();
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Aggregated timings of one phase
+struct PhaseStats {
+    std::uint64_t count = 0;
+    std::int64_t totalNs = 0;
+    std::int64_t minNs = INT64_MAX;
+    std::int64_t maxNs = 0;
+};
+
+// Run-wide instrumentation: phase timers, counters and an optional Chrome trace.
+// When disabled, timers only test one atomic flag.
+class Profiler {
+public:
+    // Process-wide instance
+    static Profiler& instance();
+
+    // Turn collection on/off; trace additionally keeps every event for export
+    void enable(bool on, bool trace = false);
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Monotonic clock in nanoseconds
+    static std::int64_t nowNs();
+
+    // Add one timed occurrence of a phase
+    void record(const char* phase, std::int64_t startNs, std::int64_t durationNs);
+
+    // Add to a named counter
+    void count(const char* counter, std::int64_t delta = 1);
+
+    // Snapshot of aggregated phases and counters
+    std::map<std::string, PhaseStats> phases() const;
+    std::map<std::string, std::int64_t> counters() const;
+
+    // Per-phase table: count, total, mean, min, max and share of run time
+    void writeSummary(std::ostream& out) const;
+
+    // Events in Chrome trace format (chrome://tracing, Perfetto)
+    void writeChromeTrace(const std::string& path) const;
+
+    // Drop everything collected so far
+    void reset();
+
+private:
+    Profiler();
+
+    // One traced event
+    struct Event {
+        const char* name;
+        std::int64_t startNs;
+        std::int64_t durationNs;
+        std::uint32_t tid;
+    };
+
+    std::atomic<bool> enabled_;
+    std::atomic<bool> trace_;
+    std::int64_t origin_;       // Trace timestamps are relative to this
+    mutable std::mutex mutex_;
+    std::map<std::string, PhaseStats> phases_;
+    std::map<std::string, std::int64_t> counters_;
+    std::vector<Event> events_;
+};
+
+// Times the enclosing scope as one occurrence of a phase.
+// The phase name must outlive the run (use string literals).
+class ScopedTimer {
+public:
+    explicit ScopedTimer(const char* phase)
+        : phase_(Profiler::instance().enabled() ? phase : nullptr),
+          start_(phase_ ? Profiler::nowNs() : 0) {}
+
+    ~ScopedTimer() {
+        if (phase_) Profiler::instance().record(phase_, start_, Profiler::nowNs() - start_);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char* phase_;
+    std::int64_t start_;
+};
+
+// Bump a counter only when profiling is on
+inline void profileCount(const char* counter, std::int64_t delta = 1) {
+    Profiler& p = Profiler::instance();
+    if (p.enabled()) p.count(counter, delta);
+}
@@ -0,0 +1,86 @@
+// Characterize stored I-V runs straight from their run files.
+//
+// Usage: ./run_analyze [--fit LO:HI] [--window N] [--min-current A] [--out FILE] [-j N] RUN...
+//   --fit LO:HI       Voltage range of the linear fit (default: whole sweep)
+//   --window N        Points in the smoothing and zero-bias fit window (default 7)
+//   --min-current A   Currents at or below A give R = 0 (default 0)
+//   --out FILE        Write the table here instead of stdout
+//   -j N              Analyze N files in parallel (default: all cores)
+// One CSV row per run: ranges, mean R, least-squares fit of I(V) and 1/slope,
+// zero-bias differential resistance, noise and outlier count.
+#include "analysis.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    AnalysisOptions options;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string outPath;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opt = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << opt << "\n";
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (opt == "--fit") {
+            std::string range = value();
+            std::size_t colon = range.find(':');
+            if (colon == std::string::npos) {
+                std::cerr << "--fit expects LO:HI\n";
+                return 2;
+            }
+            options.fitLo = std::stod(range.substr(0, colon));
+            options.fitHi = std::stod(range.substr(colon + 1));
+        } else if (opt == "--window") options.window = std::max(1, std::stoi(value()));
+        else if (opt == "--min-current") options.minCurrent = std::stod(value());
+        else if (opt == "--out") outPath = value();
+        else if (opt == "-j") threads = std::max(1, std::stoi(value()));
+        else if (!opt.empty() && opt[0] == '-') {
+            std::cerr << "Unknown option: " << opt << "\n";
+            return 2;
+        } else files.push_back(opt);
+    }
+    if (files.empty()) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--fit LO:HI] [--window N] [--min-current A] [--out FILE] [-j N] RUN...\n";
+        return 2;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<IvSummary> results = analyzeRunFiles(files, threads, options);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (outPath.empty()) {
+        writeSummaryCsv(std::cout, results);
+    } else {
+        std::ofstream out(outPath);
+        if (!out) {
+            std::cerr << "Cannot write " << outPath << "\n";
+            return 2;
+        }
+        writeSummaryCsv(out, results);
+    }
+
+    std::size_t failed = 0, points = 0;
+    for (const auto& r : results) {
+        if (!r.ok) {
+            std::fprintf(stderr, "[!] %s: %s\n", r.source.c_str(), r.error.c_str());
+            ++failed;
+        }
+        points += r.points;
+    }
+    std::fprintf(stderr, "[✓] %zu run(s), %zu points in %.3f s (%.0f runs/s)\n", files.size() - failed, points, sec,
+                 (files.size() - failed) / sec);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,34 @@
+// Convert between measurement CSV files and binary run files.
+//
+// Usage: ./run_convert to-csv   RUN CSV    Export a run file as CSV
+//        ./run_convert from-csv CSV RUN    Pack a CSV written by this program
+//        ./run_convert info     RUN        Print rows, columns and metadata
+#include "run_file.hpp"
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    std::string cmd = argc > 1 ? argv[1] : "";
+    try {
+        if (cmd == "to-csv" && argc == 4) {
+            runFileToCsv(argv[2], argv[3]);
+        } else if (cmd == "from-csv" && argc == 4) {
+            csvToRunFile(argv[2], argv[3]);
+        } else if (cmd == "info" && argc == 3) {
+            RunFileReader run(argv[2]);
+            RunColumns c = run.columns();
+            std::printf("rows: %llu\n", static_cast<unsigned long long>(run.rows()));
+            for (const auto& [key, value] : run.metadata()) std::printf("%s = %s\n", key.c_str(), value.c_str());
+            if (run.rows())
+                std::printf("voltage: %g .. %g V\n", c.voltage.front(), c.voltage.back());
+        } else {
+            std::cerr << "Usage: " << argv[0] << " to-csv RUN CSV | from-csv CSV RUN | info RUN\n";
+            return 2;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[!] " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
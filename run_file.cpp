@@ -0,0 +1,330 @@
+#include "run_file.hpp"
+#include "csv_writer.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[8] = {'C', 'D', 'A', 'R', 'U', 'N', '\0', '\0'};
+const std::uint32_t kEndianTag = 0x01020304;
+const std::uint64_t kAlign = 64;
+
+// Round up to the block alignment
+std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + kAlign - 1) / kAlign * kAlign;
+}
+
+// Size of one element of a column type
+std::size_t elementSize(RunColumnType type) {
+    return type == RunColumnType::UInt32 ? 4 : 8;
+}
+
+// One column to be written
+struct PendingColumn {
+    const char* name;
+    RunColumnType type;
+    const void* data;
+};
+
+} // namespace
+
+// Lay out header, directory, metadata and aligned column blocks; write to a temp file and rename
+void writeRunFile(const std::string& path, const RunColumns& columns, const RunMetadata& metadata) {
+    std::uint64_t rows = columns.voltage.size();
+    std::vector<PendingColumn> cols = {
+        {"monotonic_ns", RunColumnType::Int64, columns.monotonicNs.data()},
+        {"wall_ns", RunColumnType::Int64, columns.wallNs.data()},
+        {"set_voltage", RunColumnType::Float64, columns.setVoltage.data()},
+        {"voltage", RunColumnType::Float64, columns.voltage.data()},
+        {"current", RunColumnType::Float64, columns.current.data()},
+        {"resistance", RunColumnType::Float64, columns.resistance.data()},
+        {"settle_time", RunColumnType::Float64, columns.settleTime.data()},
+        {"instrument", RunColumnType::UInt32, columns.instrument.data()},
+    };
+    if (columns.monotonicNs.size() != rows || columns.wallNs.size() != rows || columns.setVoltage.size() != rows ||
+        columns.current.size() != rows || columns.resistance.size() != rows || columns.settleTime.size() != rows ||
+        columns.instrument.size() != rows)
+        throw std::invalid_argument("Run columns differ in length");
+
+    // Instruments travel in the metadata as instrument.<index>=<IDN>
+    std::string meta;
+    for (std::size_t i = 0; i < columns.instruments.size(); ++i)
+        meta += "instrument." + std::to_string(i) + "=" + columns.instruments[i].idn + "\n";
+    for (const auto& [key, value] : metadata) meta += key + "=" + value + "\n";
+
+    RunFileHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kRunFileVersion;
+    header.headerSize = sizeof(RunFileHeader);
+    header.rowCount = rows;
+    header.columnCount = static_cast<std::uint32_t>(cols.size());
+    header.endianTag = kEndianTag;
+    header.directoryOffset = sizeof(RunFileHeader);
+    header.metadataOffset = header.directoryOffset + cols.size() * sizeof(RunColumnEntry);
+    header.metadataSize = meta.size();
+
+    std::vector<RunColumnEntry> directory(cols.size());
+    std::uint64_t offset = alignUp(header.metadataOffset + meta.size());
+    for (std::size_t c = 0; c < cols.size(); ++c) {
+        std::strncpy(directory[c].name, cols[c].name, sizeof(directory[c].name) - 1);
+        directory[c].type = cols[c].type;
+        directory[c].offset = offset;
+        offset = alignUp(offset + rows * elementSize(cols[c].type));
+    }
+
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Failed to open " + tmp);
+        const char zeros[kAlign] = {};
+        std::uint64_t pos = 0;
+        auto put = [&](const void* p, std::uint64_t n) {
+            out.write(static_cast<const char*>(p), static_cast<std::streamsize>(n));
+            pos += n;
+        };
+        auto padTo = [&](std::uint64_t target) { put(zeros, target - pos); };
+
+        put(&header, sizeof(header));
+        put(directory.data(), directory.size() * sizeof(RunColumnEntry));
+        put(meta.data(), meta.size());
+        for (std::size_t c = 0; c < cols.size(); ++c) {
+            padTo(directory[c].offset);
+            put(cols[c].data, rows * elementSize(cols[c].type));
+        }
+        padTo(offset);
+        if (!out) throw std::runtime_error("Failed to write " + tmp);
+    }
+    std::filesystem::rename(tmp, path);
+}
+
+// Take all columns straight from the DataManager
+void writeRunFile(const std::string& path, const DataManager& data, const RunMetadata& metadata) {
+    RunColumns cols;
+    cols.monotonicNs = data.monotonicNs();
+    cols.wallNs = data.wallNs();
+    cols.setVoltage = data.setVoltages();
+    cols.voltage = data.voltages();
+    cols.current = data.currents();
+    cols.resistance = data.resistances();
+    cols.settleTime = data.settleTimes();
+    cols.instrument = data.instrumentIndex();
+    cols.instruments = data.instruments();
+    writeRunFile(path, cols, metadata);
+}
+
+// Map the whole file read-only and check that every block lies inside it
+RunFileReader::RunFileReader(const std::string& path) : map_(nullptr), size_(0) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("Cannot open run file: " + path);
+    struct stat st{};
+    if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(RunFileHeader))) {
+        ::close(fd);
+        throw std::runtime_error("Not a run file: " + path);
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    map_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map_ == MAP_FAILED) {
+        map_ = nullptr;
+        throw std::runtime_error("mmap failed: " + path);
+    }
+
+    auto fail = [&](const std::string& why) {
+        munmap(map_, size_);
+        map_ = nullptr;
+        throw std::runtime_error(path + ": " + why);
+    };
+
+    header_ = static_cast<const RunFileHeader*>(map_);
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) fail("bad magic");
+    if (header_->version != kRunFileVersion) fail("unsupported version " + std::to_string(header_->version));
+    if (header_->headerSize != sizeof(RunFileHeader)) fail("unexpected header size");
+    if (header_->endianTag != kEndianTag) fail("written on a machine with different byte order");
+
+    // count items of itemSize from offset lie inside the file; every value comes from the
+    // file, so each is checked against the size before anything is added or multiplied
+    auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t itemSize) {
+        return offset <= size_ && count <= (size_ - offset) / itemSize;
+    };
+    if (!fits(header_->directoryOffset, header_->columnCount, sizeof(RunColumnEntry)) ||
+        !fits(header_->metadataOffset, header_->metadataSize, 1))
+        fail("truncated header blocks");
+
+    directory_ = reinterpret_cast<const RunColumnEntry*>(static_cast<const char*>(map_) + header_->directoryOffset);
+    for (std::uint32_t c = 0; c < header_->columnCount; ++c) {
+        const RunColumnEntry& e = directory_[c];
+        if (e.offset % 8 != 0 || !fits(e.offset, header_->rowCount, elementSize(e.type)))
+            fail("column block out of bounds");
+    }
+
+    // Metadata is small; parse it once
+    std::string meta(static_cast<const char*>(map_) + header_->metadataOffset, header_->metadataSize);
+    std::size_t start = 0;
+    while (start < meta.size()) {
+        std::size_t nl = meta.find('\n', start);
+        if (nl == std::string::npos) nl = meta.size();
+        std::string line = meta.substr(start, nl - start);
+        std::size_t eq = line.find('=');
+        if (eq != std::string::npos) metadata_.emplace_back(line.substr(0, eq), line.substr(eq + 1));
+        start = nl + 1;
+    }
+}
+
+// Unmap on destruction; spans handed out become invalid
+RunFileReader::~RunFileReader() {
+    if (map_) munmap(map_, size_);
+}
+
+std::uint64_t RunFileReader::rows() const {
+    return header_->rowCount;
+}
+
+const RunMetadata& RunFileReader::metadata() const {
+    return metadata_;
+}
+
+std::string RunFileReader::meta(const std::string& key, const std::string& fallback) const {
+    for (const auto& [k, v] : metadata_)
+        if (k == key) return v;
+    return fallback;
+}
+
+// Directory lookup by name and type
+const void* RunFileReader::column(const std::string& name, RunColumnType type) const {
+    for (std::uint32_t c = 0; c < header_->columnCount; ++c) {
+        const RunColumnEntry& e = directory_[c];
+        if (std::strncmp(e.name, name.c_str(), sizeof(e.name)) != 0) continue;
+        if (e.type != type) throw std::runtime_error("Column " + name + " has a different type");
+        return static_cast<const char*>(map_) + e.offset;
+    }
+    throw std::runtime_error("No column named " + name);
+}
+
+std::span<const double> RunFileReader::f64(const std::string& name) const {
+    return {static_cast<const double*>(column(name, RunColumnType::Float64)), header_->rowCount};
+}
+
+std::span<const std::int64_t> RunFileReader::i64(const std::string& name) const {
+    return {static_cast<const std::int64_t*>(column(name, RunColumnType::Int64)), header_->rowCount};
+}
+
+std::span<const std::uint32_t> RunFileReader::u32(const std::string& name) const {
+    return {static_cast<const std::uint32_t*>(column(name, RunColumnType::UInt32)), header_->rowCount};
+}
+
+// Standard columns plus instruments rebuilt from the metadata
+RunColumns RunFileReader::columns() const {
+    RunColumns cols;
+    cols.monotonicNs = i64("monotonic_ns");
+    cols.wallNs = i64("wall_ns");
+    cols.setVoltage = f64("set_voltage");
+    cols.voltage = f64("voltage");
+    cols.current = f64("current");
+    cols.resistance = f64("resistance");
+    cols.settleTime = f64("settle_time");
+    cols.instrument = u32("instrument");
+    for (std::size_t i = 0;; ++i) {
+        std::string key = "instrument." + std::to_string(i);
+        auto it = std::find_if(metadata_.begin(), metadata_.end(), [&](const auto& kv) { return kv.first == key; });
+        if (it == metadata_.end()) break;
+        cols.instruments.push_back(DataManager::parseIdn(it->second));
+    }
+    return cols;
+}
+
+// Stream every row through the CSV writer
+void runFileToCsv(const std::string& runPath, const std::string& csvPath) {
+    RunFileReader reader(runPath);
+    RunColumns c = reader.columns();
+    std::filesystem::remove(csvPath);
+    CsvFlushPolicy policy;
+    policy.bufferBytes = 1 << 20;
+    policy.everySeconds = 0;
+    CsvStreamWriter out(csvPath, policy, FsyncPolicy::OnClose);
+    InstrumentInfo unknown{"", "N/A", "N/A", "N/A", "N/A"};
+    for (std::size_t i = 0; i < reader.rows(); ++i) {
+        const InstrumentInfo& inst = c.instrument[i] < c.instruments.size() ? c.instruments[c.instrument[i]] : unknown;
+        out.appendRow(c.wallNs[i], inst, c.voltage[i], c.current[i], c.resistance[i], c.settleTime[i],
+                      c.setVoltage[i]);
+    }
+    out.close();
+}
+
+// Parse the CSV into columns; the monotonic clock is not in the CSV, so wall time stands in
+void csvToRunFile(const std::string& csvPath, const std::string& runPath) {
+    std::ifstream in(csvPath);
+    if (!in) throw std::runtime_error("Cannot open " + csvPath);
+
+    std::string line;
+    if (!std::getline(in, line) || line.rfind("Timestamp,", 0) != 0)
+        throw std::runtime_error(csvPath + " is not a measurement CSV");
+
+    std::vector<std::int64_t> wall;
+    std::vector<double> setV, volt, curr, res, settle;
+    std::vector<std::uint32_t> inst;
+    std::vector<InstrumentInfo> instruments;
+
+    auto number = [](const std::string& s) {
+        double v = std::numeric_limits<double>::quiet_NaN();
+        if (s == "nan" || s == "-nan" || s.empty()) return v;
+        std::from_chars(s.data(), s.data() + s.size(), v);
+        return v;
+    };
+
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        std::vector<std::string> f;
+        std::size_t start = 0;
+        while (true) {
+            std::size_t comma = line.find(',', start);
+            f.push_back(line.substr(start, comma - start));
+            if (comma == std::string::npos) break;
+            start = comma + 1;
+        }
+        if (f.size() < 9) throw std::runtime_error("Short CSV row: " + line);
+
+        std::tm tm{};
+        tm.tm_isdst = -1;
+        if (std::sscanf(f[0].c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                        &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+            throw std::runtime_error("Bad timestamp: " + f[0]);
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+        wall.push_back(static_cast<std::int64_t>(std::mktime(&tm)) * 1000000000);
+
+        std::string idn = f[1] + "," + f[2] + "," + f[3] + "," + f[4];
+        std::uint32_t index = 0;
+        while (index < instruments.size() && instruments[index].idn != idn) ++index;
+        if (index == instruments.size()) instruments.push_back({idn, f[1], f[2], f[3], f[4]});
+        inst.push_back(index);
+
+        volt.push_back(number(f[5]));
+        curr.push_back(number(f[6]));
+        res.push_back(number(f[7]));
+        settle.push_back(number(f[8]));
+        setV.push_back(f.size() > 9 ? number(f[9]) : std::numeric_limits<double>::quiet_NaN());
+    }
+
+    RunColumns cols;
+    cols.monotonicNs = wall;
+    cols.wallNs = wall;
+    cols.setVoltage = setV;
+    cols.voltage = volt;
+    cols.current = curr;
+    cols.resistance = res;
+    cols.settleTime = settle;
+    cols.instrument = inst;
+    cols.instruments = instruments;
+    writeRunFile(runPath, cols, {{"source", csvPath}});
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+#include "data_manager.hpp"
+
+// Versioned binary run file.
+//
+// Layout (host byte order, little-endian on supported machines):
+//   RunFileHeader                    64 bytes at offset 0
+//   column directory                 columnCount x RunColumnEntry
+//   metadata                         "key=value\n" text
+//   column blocks                    rowCount values each, every block 64-byte aligned
+//
+// Because every block is aligned and stored in native layout, a reader can
+// mmap the file and hand out std::span views without parsing anything.
+
+// File header
+struct RunFileHeader {
+    char magic[8];               // "CDARUN\0\0"
+    std::uint32_t version;       // kRunFileVersion
+    std::uint32_t headerSize;    // sizeof(RunFileHeader)
+    std::uint64_t rowCount;
+    std::uint32_t columnCount;
+    std::uint32_t endianTag;     // 0x01020304 as written by the producer
+    std::uint64_t directoryOffset;
+    std::uint64_t metadataOffset;
+    std::uint64_t metadataSize;
+    std::uint64_t reserved;
+};
+static_assert(sizeof(RunFileHeader) == 64, "Run file header must stay 64 bytes");
+
+// Element type of a column block
+enum class RunColumnType : std::uint32_t {
+    Float64 = 1,
+    Int64 = 2,
+    UInt32 = 3
+};
+
+// One entry of the column directory
+struct RunColumnEntry {
+    char name[16];               // Zero-padded column name
+    RunColumnType type;
+    std::uint32_t reserved;
+    std::uint64_t offset;        // Absolute file offset of the block
+};
+static_assert(sizeof(RunColumnEntry) == 32, "Run column entry must stay 32 bytes");
+
+constexpr std::uint32_t kRunFileVersion = 1;
+
+// Free-form run description (instrument, sweep parameters, ...)
+using RunMetadata = std::vector<std::pair<std::string, std::string>>;
+
+// Views of one run's columns; all spans have the same length
+struct RunColumns {
+    std::span<const std::int64_t> monotonicNs;
+    std::span<const std::int64_t> wallNs;
+    std::span<const double> setVoltage;
+    std::span<const double> voltage;
+    std::span<const double> current;
+    std::span<const double> resistance;
+    std::span<const double> settleTime;
+    std::span<const std::uint32_t> instrument;   // Index into instruments
+    std::vector<InstrumentInfo> instruments;
+};
+
+// Write a run file from column views and metadata
+void writeRunFile(const std::string& path, const RunColumns& columns, const RunMetadata& metadata);
+
+// Write everything a DataManager holds, plus extra metadata (sweep parameters)
+void writeRunFile(const std::string& path, const DataManager& data, const RunMetadata& metadata = {});
+
+// Memory-mapped, zero-copy reader of a run file
+class RunFileReader {
+public:
+    // Map the file and validate header and directory (throws on mismatch)
+    explicit RunFileReader(const std::string& path);
+    ~RunFileReader();
+
+    RunFileReader(const RunFileReader&) = delete;
+    RunFileReader& operator=(const RunFileReader&) = delete;
+
+    std::uint64_t rows() const;
+    const RunMetadata& metadata() const;
+
+    // Value of a metadata key, or fallback if absent
+    std::string meta(const std::string& key, const std::string& fallback = "") const;
+
+    // Typed column views straight into the mapping (throws if missing or wrong type)
+    std::span<const double> f64(const std::string& name) const;
+    std::span<const std::int64_t> i64(const std::string& name) const;
+    std::span<const std::uint32_t> u32(const std::string& name) const;
+
+    // All standard columns at once
+    RunColumns columns() const;
+
+private:
+    // Locate a column of the given type
+    const void* column(const std::string& name, RunColumnType type) const;
+
+    void* map_;
+    std::size_t size_;
+    const RunFileHeader* header_;
+    const RunColumnEntry* directory_;
+    RunMetadata metadata_;
+};
+
+// Convert a run file to the CSV layout written by CsvStreamWriter
+void runFileToCsv(const std::string& runPath, const std::string& csvPath);
+
+// Convert a CSV written by this program back to a run file
+void csvToRunFile(const std::string& csvPath, const std::string& runPath);
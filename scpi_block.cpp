@@ -0,0 +1,92 @@
+#include "scpi_block.hpp"
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <bit>
+
+// Host order decides which FORM:BORD avoids a byte swap
+ByteOrder nativeByteOrder() {
+    return std::endian::native == std::endian::little ? ByteOrder::Swapped : ByteOrder::Normal;
+}
+
+// Read '#', digit count and decimal payload length
+std::size_t parseBlockHeader(const char* buf, std::size_t avail, std::size_t& payload) {
+    if (avail < 2) return 0;
+    if (buf[0] != '#') throw std::runtime_error("Expected binary block, got: " + std::string(buf, avail < 32 ? avail : 32));
+    if (buf[1] < '1' || buf[1] > '9')
+        throw std::runtime_error("Unsupported block header (indefinite length or garbled)");
+
+    std::size_t digits = static_cast<std::size_t>(buf[1] - '0');
+    if (avail < 2 + digits) return 0;
+
+    std::size_t len = 0;
+    for (std::size_t i = 0; i < digits; ++i) {
+        char c = buf[2 + i];
+        if (c < '0' || c > '9') throw std::runtime_error("Garbled block length");
+        len = len * 10 + static_cast<std::size_t>(c - '0');
+    }
+    payload = len;
+    return 2 + digits;
+}
+
+// Byte-reverse each 8-byte value
+void swapReal64(double* data, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &data[i], sizeof(bits));
+        bits = __builtin_bswap64(bits);
+        std::memcpy(&data[i], &bits, sizeof(bits));
+    }
+}
+
+// Copy the payload straight into the destination and fix byte order there
+std::size_t decodeRealBlock(std::string_view block, ByteOrder order, std::span<double> out) {
+    std::size_t payload = 0;
+    std::size_t header = parseBlockHeader(block.data(), block.size(), payload);
+    if (header == 0 || block.size() < header + payload)
+        throw std::runtime_error("Truncated binary block");
+    if (payload % sizeof(double) != 0)
+        throw std::runtime_error("Block length is not a multiple of 8 bytes");
+
+    std::size_t count = payload / sizeof(double);
+    if (count > out.size()) throw std::runtime_error("Binary block larger than destination");
+    std::memcpy(out.data(), block.data() + header, payload);
+    if (order != nativeByteOrder()) swapReal64(out.data(), count);
+    return count;
+}
+
+// Walk the list with from_chars; SCPI numbers may carry a leading '+'
+std::size_t parseAsciiReals(std::string_view text, std::span<double> out) {
+    const char* p = text.data();
+    const char* end = p + text.size();
+    std::size_t n = 0;
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == ',')) ++p;
+        if (p == end) break;
+        if (*p == '+') ++p;
+        if (n == out.size()) throw std::runtime_error("Number list larger than destination");
+        auto [next, ec] = std::from_chars(p, end, out[n]);
+        if (ec != std::errc())
+            throw std::runtime_error("Malformed number list: " + std::string(text.substr(0, 64)));
+        ++n;
+        p = next;
+    }
+    return n;
+}
+
+// Fields are separated by commas; an empty reply holds no values
+std::size_t countAsciiReals(std::string_view text) {
+    if (text.find_first_not_of(" \r\n") == std::string_view::npos) return 0;
+    std::size_t n = 1;
+    for (char c : text)
+        if (c == ',') ++n;
+    return n;
+}
+
+std::string formatReal(double value) {
+    char text[32];
+    auto [end, ec] = std::to_chars(text, text + sizeof(text), value);
+    return std::string(text, ec == std::errc() ? end : text);
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Helpers for encoding numeric SCPI parameters and decoding numeric responses.
+//
+// With FORM:DATA REAL,64 the instrument answers array queries with an
+// IEEE 488.2 definite-length block: '#', one digit n, n digits giving the
+// payload length, then the raw doubles. FORM:BORD NORM sends them
+// big-endian, FORM:BORD SWAP little-endian.
+
+// Byte order of binary payloads as selected with FORM:BORD
+enum class ByteOrder {
+    Normal,   // Big-endian (FORM:BORD NORM)
+    Swapped   // Little-endian (FORM:BORD SWAP)
+};
+
+// Byte order that lets payloads be used without swapping on this host
+ByteOrder nativeByteOrder();
+
+// Parse a '#<n><len>' header at the start of buf.
+// Returns the header size and stores the payload length, or returns 0 if
+// more bytes are needed. Throws on malformed or indefinite-length blocks.
+std::size_t parseBlockHeader(const char* buf, std::size_t avail, std::size_t& payload);
+
+// Reverse the byte order of every double in place
+void swapReal64(double* data, std::size_t count);
+
+// Decode a complete block response (header + payload) into out, returns values written
+std::size_t decodeRealBlock(std::string_view block, ByteOrder order, std::span<double> out);
+
+// Parse a comma separated ASCII number list into out, returns values written
+std::size_t parseAsciiReals(std::string_view text, std::span<double> out);
+
+// Number of comma separated fields in an ASCII number list
+std::size_t countAsciiReals(std::string_view text);
+
+// Shortest text that parses back to the same double, for numeric command
+// parameters (std::to_string would round to 1e-6 and send 5e-8 V as 0)
+std::string formatReal(double value);
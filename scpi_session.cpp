@@ -0,0 +1,369 @@
+#include "scpi_session.hpp"
+#include "scpi_block.hpp"
+#include "profiler.hpp"
+#include <stdexcept>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+static std::int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const char* faultName(ScpiFault fault) {
+    switch (fault) {
+        case ScpiFault::Connect: return "connect";
+        case ScpiFault::Timeout: return "timeout";
+        case ScpiFault::Reset: return "reset";
+        case ScpiFault::Short: return "short";
+        case ScpiFault::Garbled: return "garbled";
+    }
+    return "unknown";
+}
+
+ScpiError::ScpiError(ScpiFault fault, const std::string& what) : std::runtime_error(what), fault_(fault) {}
+
+ScpiFault ScpiError::fault() const {
+    return fault_;
+}
+
+// Store the endpoint; the socket is opened on first use
+ScpiSession::ScpiSession(const std::string& ip, int port)
+    : ip_(ip), port_(port), fd_(-1), rxPos_(0), connects_(0), deadlineNs_(0), capture_(false), replayPos_(0) {}
+
+// Close the socket when the session goes away
+ScpiSession::~ScpiSession() {
+    disconnect();
+}
+
+// Open the TCP connection to the instrument. The socket stays non-blocking:
+// every later send and recv waits in poll() against the current deadline.
+void ScpiSession::connect() {
+    if (fd_ >= 0 || replay_) return;
+
+    int sockfd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sockfd < 0) throw std::runtime_error("Socket creation failed");
+
+    sockaddr_in serv_addr{};
+    serv_addr.sin_family = AF_INET;
+    serv_addr.sin_port = htons(port_);
+    if (inet_pton(AF_INET, ip_.c_str(), &serv_addr.sin_addr) != 1) {
+        ::close(sockfd);
+        throw std::runtime_error("Invalid instrument address: " + ip_);
+    }
+
+    int err = 0;
+    if (::connect(sockfd, (struct sockaddr*)&serv_addr, sizeof(serv_addr)) < 0) {
+        err = errno;
+        if (err == EINPROGRESS) {
+            // Wait for the handshake, then read its outcome
+            pollfd p{sockfd, POLLOUT, 0};
+            std::int64_t until = steadyNs() + static_cast<std::int64_t>(policy_.connectTimeout * 1e9);
+            int n;
+            do {
+                int ms = static_cast<int>(std::max<std::int64_t>(0, (until - steadyNs() + 999999) / 1000000));
+                n = ::poll(&p, 1, ms);
+            } while (n < 0 && errno == EINTR);
+            socklen_t len = sizeof(err);
+            if (n == 0) err = ETIMEDOUT;
+            else if (n < 0 || getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) err = errno;
+        }
+    }
+    if (err != 0) {
+        ::close(sockfd);
+        throw fault(ScpiFault::Connect, std::string("Connect failed: ") + std::strerror(err));
+    }
+
+    // Short SCPI messages must not wait for Nagle coalescing
+    int one = 1;
+    setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    fd_ = sockfd;
+    rx_.clear();
+    rxPos_ = 0;
+    ++connects_;
+    stats_.connects = connects_;
+    profileCount("scpi.connects");
+}
+
+// Counters per fault class feed the run statistics (profile summary, run metadata)
+ScpiError ScpiSession::fault(ScpiFault kind, const std::string& what) {
+    switch (kind) {
+        case ScpiFault::Connect:
+            ++stats_.connectFailures;
+            profileCount("scpi.connect_failures");
+            break;
+        case ScpiFault::Timeout:
+            ++stats_.timeouts;
+            profileCount("scpi.timeouts");
+            break;
+        case ScpiFault::Reset:
+            ++stats_.resets;
+            profileCount("scpi.resets");
+            break;
+        case ScpiFault::Short:
+            ++stats_.shortReplies;
+            profileCount("scpi.short_replies");
+            break;
+        case ScpiFault::Garbled:
+            ++stats_.garbled;
+            profileCount("scpi.garbled");
+            break;
+    }
+    disconnect();
+    return ScpiError(kind, what);
+}
+
+void ScpiSession::waitReady(short events) {
+    while (true) {
+        std::int64_t left = deadlineNs_ - steadyNs();
+        if (left <= 0) {
+            throw fault(ScpiFault::Timeout, "No reply to '" + lastMessage_.substr(0, 64) + "' within the deadline");
+        }
+        pollfd p{fd_, events, 0};
+        int n = ::poll(&p, 1, static_cast<int>((left + 999999) / 1000000));
+        if (n > 0) return;  // Errors and hang-ups surface in the following send/recv
+        if (n < 0 && errno != EINTR) throw fault(ScpiFault::Reset, std::string("poll failed: ") + std::strerror(errno));
+    }
+}
+
+void ScpiSession::setPolicy(const ScpiPolicy& policy) {
+    policy_ = policy;
+}
+
+const ScpiPolicy& ScpiSession::policy() const {
+    return policy_;
+}
+
+const ScpiLinkStats& ScpiSession::stats() const {
+    return stats_;
+}
+
+// Close the socket and forget buffered input
+void ScpiSession::disconnect() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    rx_.clear();
+    rxPos_ = 0;
+}
+
+bool ScpiSession::isConnected() const {
+    return fd_ >= 0 || replay_;
+}
+
+std::size_t ScpiSession::connectCount() const {
+    return connects_;
+}
+
+void ScpiSession::setCapture(bool on) {
+    capture_ = on;
+}
+
+const std::vector<CommandRecord>& ScpiSession::captured() const {
+    return captured_;
+}
+
+// Switch to the recorded log; the socket is no longer used
+void ScpiSession::replay(std::shared_ptr<const CommandLogReader> log) {
+    disconnect();
+    replay_ = std::move(log);
+    replayPos_ = 0;
+}
+
+bool ScpiSession::replaying() const {
+    return replay_ != nullptr;
+}
+
+void ScpiSession::discardCapture(const std::string& message) {
+    if (capture_ && !captured_.empty() && captured_.back().first == message) captured_.pop_back();
+}
+
+void ScpiSession::captureReceived(const char* data, std::size_t n) {
+    if (capture_ && !captured_.empty()) captured_.back().second.append(data, n);
+}
+
+// Send the whole message plus the '\n' terminator
+void ScpiSession::write(const std::string& message) {
+    if (replay_) {
+        // Queue the recorded reply bytes as if they had arrived from the instrument
+        if (replayPos_ >= replay_->size())
+            throw std::runtime_error("Replay log exhausted at: " + message);
+        if (replay_->command(replayPos_) != message)
+            throw std::runtime_error("Replay diverged at record " + std::to_string(replayPos_) + ": sent '" +
+                                     message + "', recorded '" + std::string(replay_->command(replayPos_)) + "'");
+        if (rxPos_ == rx_.size()) {
+            rx_.clear();
+            rxPos_ = 0;
+        }
+        std::string_view reply = replay_->response(replayPos_++);
+        rx_.append(reply);
+        if (!reply.empty() && reply.back() != '\n') rx_ += '\n';  // Logs of parsed values lack terminators
+        return;
+    }
+    connect();
+    lastMessage_ = message;
+    deadlineNs_ = steadyNs() + static_cast<std::int64_t>(policy_.replyTimeout * 1e9);
+    std::string out = message + "\n";  // SCPI commands are newline-terminated
+    std::size_t sent = 0;
+    while (sent < out.size()) {
+        ssize_t n = send(fd_, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                waitReady(POLLOUT);
+                continue;
+            }
+            throw fault(ScpiFault::Reset, std::string("Send failed: ") + std::strerror(errno));
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    if (capture_) captured_.emplace_back(message, std::string());
+}
+
+// Append whatever the socket has to the receive buffer
+void ScpiSession::fillBuffer() {
+    if (replay_) throw std::runtime_error("Replay log has no more reply data");
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(fd_, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            rx_.append(buffer, static_cast<std::size_t>(n));
+            captureReceived(buffer, static_cast<std::size_t>(n));
+            return;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            waitReady(POLLIN);
+            continue;
+        }
+        // Part of a reply already in hand means it was cut short
+        if (n == 0 && rxPos_ < rx_.size()) throw fault(ScpiFault::Short, "Connection closed mid-reply");
+        throw fault(ScpiFault::Reset, n == 0 ? "Connection closed by instrument"
+                                             : std::string("Receive failed: ") + std::strerror(errno));
+    }
+}
+
+// Read one newline-terminated response, stripping the terminator
+std::string ScpiSession::readLine() {
+    connect();
+    if (rxPos_ == rx_.size()) {
+        rx_.clear();
+        rxPos_ = 0;
+    }
+    std::size_t scanFrom = rxPos_;
+    while (true) {
+        std::size_t nl = rx_.find('\n', scanFrom);
+        if (nl != std::string::npos) {
+            std::size_t end = nl;
+            if (end > rxPos_ && rx_[end - 1] == '\r') --end;
+            std::string line = rx_.substr(rxPos_, end - rxPos_);
+            rxPos_ = nl + 1;
+            return line;
+        }
+        scanFrom = rx_.size();
+        fillBuffer();
+    }
+}
+
+// Buffer bytes until a complete block header is available
+std::size_t ScpiSession::readBlockHeader() {
+    connect();
+    while (true) {
+        std::size_t payload = 0;
+        std::size_t header = 0;
+        try {
+            header = parseBlockHeader(rx_.data() + rxPos_, rx_.size() - rxPos_, payload);
+        } catch (const std::runtime_error& e) {
+            if (replay_) throw;
+            throw fault(ScpiFault::Garbled, e.what());
+        }
+        if (header > 0) {
+            rxPos_ += header;
+            return payload;
+        }
+        fillBuffer();
+    }
+}
+
+// Drain buffered bytes first, then receive the rest directly into the destination
+void ScpiSession::readExact(void* dst, std::size_t n) {
+    connect();
+    char* out = static_cast<char*>(dst);
+    std::size_t buffered = std::min(n, rx_.size() - rxPos_);
+    std::memcpy(out, rx_.data() + rxPos_, buffered);
+    rxPos_ += buffered;
+
+    std::size_t got = buffered;
+    if (got < n && replay_) throw std::runtime_error("Replay log has no more block data");
+    while (got < n) {
+        ssize_t r = recv(fd_, out + got, n - got, 0);
+        if (r > 0) {
+            captureReceived(out + got, static_cast<std::size_t>(r));
+            got += static_cast<std::size_t>(r);
+            continue;
+        }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            waitReady(POLLIN);
+            continue;
+        }
+        throw fault(r == 0 ? ScpiFault::Short : ScpiFault::Reset,
+                    r == 0 ? "Connection closed during block transfer"
+                           : std::string("Receive failed: ") + std::strerror(errno));
+    }
+}
+
+// Send a command without reply; repeating a setting is harmless
+void ScpiSession::command(const std::string& message) {
+    exchange(message, nullptr);
+}
+
+// Send a query and read its response
+std::string ScpiSession::query(const std::string& message, bool idempotent, double timeout) {
+    return transact(message, 1, idempotent, timeout).front();
+}
+
+// Write a message and collect several response lines
+std::vector<std::string> ScpiSession::transact(const std::string& message, std::size_t replies, bool idempotent,
+                                               double timeout) {
+    std::vector<std::string> lines;
+    exchange(message, [&] {
+        lines.clear();
+        lines.reserve(replies);
+        for (std::size_t i = 0; i < replies; ++i) lines.push_back(readLine());
+    }, idempotent, timeout);
+    return lines;
+}
+
+// Retries back off exponentially so a struggling instrument is not flooded
+void ScpiSession::exchange(const std::string& message, const std::function<void()>& read, bool idempotent,
+                           double timeout) {
+    double pause = policy_.backoff;
+    for (int attempt = 0;; ++attempt) {
+        try {
+            write(message);
+            if (timeout > 0) deadlineNs_ = steadyNs() + static_cast<std::int64_t>(timeout * 1e9);
+            if (read) read();
+            return;
+        } catch (const ScpiError& e) {
+            // Raised by the reader (reply did not parse): count it and resync by reconnecting
+            if (fd_ >= 0) fault(e.fault(), e.what());
+            discardCapture(message);
+            if (attempt >= policy_.retries || (!idempotent && e.fault() != ScpiFault::Connect)) throw;
+        }
+        ++stats_.retries;
+        profileCount("scpi.retries");
+        std::this_thread::sleep_for(std::chrono::duration<double>(pause));
+        pause = std::min(pause * 2, policy_.maxBackoff);
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include "command_log.hpp"
+
+// Why an exchange with the instrument failed
+enum class ScpiFault {
+    Connect,   // No connection within the connect timeout (nothing was sent)
+    Timeout,   // No complete reply before the deadline
+    Reset,     // The instrument closed or reset the connection
+    Short,     // The reply ended early (connection lost mid-line or mid-block)
+    Garbled    // The reply does not parse (bad block header, wrong field count, ...)
+};
+
+// Lower-case name of a fault ("timeout", ...)
+const char* faultName(ScpiFault fault);
+
+// A failed exchange; still a runtime_error for callers that do not care about the class
+class ScpiError : public std::runtime_error {
+public:
+    ScpiError(ScpiFault fault, const std::string& what);
+    ScpiFault fault() const;
+
+private:
+    ScpiFault fault_;
+};
+
+// Deadlines and retries of a session
+struct ScpiPolicy {
+    double connectTimeout = 3.0;   // Seconds for a non-blocking connect
+    double replyTimeout = 10.0;    // Seconds from sending a message to the end of its reply
+    double listPointTime = 0.1;    // Allowance per list sweep point for integration and averaging (s)
+    int retries = 2;               // Further attempts of a failed exchange
+    double backoff = 0.05;         // Pause before the first retry (s), doubled after each one
+    double maxBackoff = 1.0;       // Longest pause between retries (s)
+};
+
+// Link health of a session since it was created
+struct ScpiLinkStats {
+    std::size_t connects = 0;
+    std::size_t connectFailures = 0;
+    std::size_t timeouts = 0;
+    std::size_t resets = 0;
+    std::size_t shortReplies = 0;
+    std::size_t garbled = 0;
+    std::size_t retries = 0;
+};
+
+// Long-lived TCP connection to a SCPI instrument (raw socket, usually port 5025).
+// The connection is opened lazily, kept for the whole run and re-established
+// automatically when the instrument drops the link.
+//
+// Every wait is bounded: connecting by the policy's connect timeout, and a
+// message plus its whole reply by one deadline. A failed exchange closes the
+// connection, so a late reply can never be taken for the answer to a later
+// message, and is repeated with backoff when that is safe (see exchange()).
+//
+// The session can also record its traffic (one record per written message,
+// holding every byte received before the next write) and later replay such a
+// recording in place of the socket, for offline analysis and benchmarking.
+class ScpiSession {
+public:
+    ScpiSession(const std::string& ip, int port);
+    ~ScpiSession();
+
+    ScpiSession(const ScpiSession&) = delete;
+    ScpiSession& operator=(const ScpiSession&) = delete;
+
+    // Open the connection (no-op if already connected)
+    void connect();
+
+    // Close the connection and drop any buffered input
+    void disconnect();
+
+    bool isConnected() const;
+
+    // Send a program message that produces no reply
+    void command(const std::string& message);
+
+    // Send a query and read its newline-terminated response
+    std::string query(const std::string& message, bool idempotent = true, double timeout = 0.0);
+
+    // Send a message and read the given number of response lines in one round trip
+    std::vector<std::string> transact(const std::string& message, std::size_t replies, bool idempotent = true,
+                                      double timeout = 0.0);
+
+    // Write a message and collect its reply with read() (readLine, readBlockHeader,
+    // readExact) before the deadline; timeout 0 uses the policy's reply timeout.
+    // Failed idempotent exchanges are repeated up to policy().retries times; others
+    // only when the connection could not be opened, since they may have taken effect.
+    void exchange(const std::string& message, const std::function<void()>& read, bool idempotent = true,
+                  double timeout = 0.0);
+
+    // Write one program message (terminator is appended); its reply is due within the reply timeout
+    void write(const std::string& message);
+
+    // Read one response up to the '\n' terminator, however many recv calls it takes
+    std::string readLine();
+
+    // Read an IEEE 488.2 '#<n><len>' block header and return the payload length
+    std::size_t readBlockHeader();
+
+    // Read exactly n bytes into dst; bytes not yet buffered go straight from the socket
+    void readExact(void* dst, std::size_t n);
+
+    // Number of times the connection was (re)established
+    std::size_t connectCount() const;
+
+    // Timeouts and retry behaviour
+    void setPolicy(const ScpiPolicy& policy);
+    const ScpiPolicy& policy() const;
+
+    // Faults and retries so far
+    const ScpiLinkStats& stats() const;
+
+    // Start or stop recording written messages and the bytes received for them
+    void setCapture(bool on);
+    const std::vector<CommandRecord>& captured() const;
+
+    // Serve writes and reads from a recorded log instead of the socket.
+    // Every write must match the next recorded command, otherwise runtime_error.
+    void replay(std::shared_ptr<const CommandLogReader> log);
+    bool replaying() const;
+
+private:
+    // Pull more bytes from the socket into the receive buffer
+    void fillBuffer();
+
+    // Wait until the socket is ready for events, at most until the deadline
+    void waitReady(short events);
+
+    // Count a fault, drop the connection and return the error to throw
+    ScpiError fault(ScpiFault kind, const std::string& what);
+
+    // Drop the record of a message whose exchange failed and will be retried
+    void discardCapture(const std::string& message);
+
+    // Remember bytes received for the last written message
+    void captureReceived(const char* data, std::size_t n);
+
+    std::string ip_;
+    int port_;
+    int fd_;
+    std::string rx_;        // Received but not yet consumed bytes
+    std::size_t rxPos_;     // Read position inside rx_
+    std::size_t connects_;
+    ScpiPolicy policy_;
+    ScpiLinkStats stats_;
+    std::int64_t deadlineNs_;   // steady_clock time the current reply is due by
+    std::string lastMessage_;   // For error messages
+
+    bool capture_;
+    std::vector<CommandRecord> captured_;
+    std::shared_ptr<const CommandLogReader> replay_;
+    std::size_t replayPos_;   // Next record to replay
+};
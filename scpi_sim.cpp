@@ -0,0 +1,84 @@
+// Simulated SCPI instrument for testing and benchmarking without hardware.
+//
+// Usage: ./scpi_sim [options]
+//   --port N            TCP port (default 5025)
+//   --model resistor|diode
+//   --resistance OHM    Resistor value (default 1000)
+//   --is A              Diode saturation current (default 1e-12)
+//   --ideality N        Diode ideality factor (default 1.8)
+//   --noise REL         Relative gaussian noise on readings
+//   --noise-abs A       Absolute gaussian noise on current
+//   --latency-ms MS     Delay before every reply
+//   --jitter-ms MS      Uniform random extra reply delay
+//   --tau-ms MS         Source settling time constant
+//   --no-list           Reject list sweep mode
+//   --drop-every N      Drop the connection on every Nth message
+//   --slow-prob P       Probability that a reply is slow
+//   --slow-ms MS        Extra delay of a slow reply
+//   --aperture-ms MS    Integration time of one reading
+//   --no-aver           Reject :SENS:AVER (no instrument-side averaging)
+//   --cap F             Zero-bias junction capacitance (default 100e-12)
+//   --freq-delay-ms MS  LCR: delay after a frequency change
+//   --level-delay-ms MS LCR: delay after an AC level change
+//   --range-delay-ms MS LCR: delay when the impedance range changes
+#include "scpi_simulator.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    SimConfig config;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string opt = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << opt << "\n";
+                std::exit(1);
+            }
+            return argv[++i];
+        };
+
+        if (opt == "--port") config.port = std::stoi(value());
+        else if (opt == "--model") {
+            std::string m = value();
+            if (m == "resistor") config.model = SimModel::Resistor;
+            else if (m == "diode") config.model = SimModel::Diode;
+            else { std::cerr << "Unknown model: " << m << "\n"; return 1; }
+        }
+        else if (opt == "--resistance") config.resistance = std::stod(value());
+        else if (opt == "--is") config.saturationCurrent = std::stod(value());
+        else if (opt == "--ideality") config.ideality = std::stod(value());
+        else if (opt == "--noise") config.noiseRel = std::stod(value());
+        else if (opt == "--noise-abs") config.noiseAbs = std::stod(value());
+        else if (opt == "--latency-ms") config.latency = std::stod(value()) / 1000.0;
+        else if (opt == "--jitter-ms") config.jitter = std::stod(value()) / 1000.0;
+        else if (opt == "--tau-ms") config.settleTau = std::stod(value()) / 1000.0;
+        else if (opt == "--no-list") config.listSupport = false;
+        else if (opt == "--drop-every") config.dropEvery = std::stoi(value());
+        else if (opt == "--slow-prob") config.slowProbability = std::stod(value());
+        else if (opt == "--slow-ms") config.slowDelay = std::stod(value()) / 1000.0;
+        else if (opt == "--aperture-ms") config.aperture = std::stod(value()) / 1000.0;
+        else if (opt == "--no-aver") config.averagingSupport = false;
+        else if (opt == "--cap") config.capacitance = std::stod(value());
+        else if (opt == "--freq-delay-ms") config.freqChangeDelay = std::stod(value()) / 1000.0;
+        else if (opt == "--level-delay-ms") config.levelChangeDelay = std::stod(value()) / 1000.0;
+        else if (opt == "--range-delay-ms") config.rangeChangeDelay = std::stod(value()) / 1000.0;
+        else {
+            std::cerr << "Unknown option: " << opt << "\n";
+            return 1;
+        }
+    }
+
+    try {
+        ScpiSimulator sim(config);
+        sim.listen();
+        std::cout << "[*] Simulated instrument listening on " << config.bindAddress << ":" << sim.port() << std::endl;
+        sim.serve();
+    } catch (const std::exception& e) {
+        std::cerr << "[!] " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,488 @@
+#include "scpi_simulator.hpp"
+#include "scpi_block.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+namespace {
+
+const double kThermalVoltage = 0.025852;  // kT/q at 300 K
+
+// Trim spaces and tabs from both ends
+std::string trim(const std::string& s) {
+    std::size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return "";
+    std::size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+// Uppercase copy
+std::string upper(std::string s) {
+    for (auto& c : s) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// SCPI short form of a keyword: first four letters, three if the fourth is a vowel
+std::string shortForm(const std::string& node) {
+    if (node.size() <= 4) return node;
+    char fourth = node[3];
+    bool vowel = fourth == 'A' || fourth == 'E' || fourth == 'I' || fourth == 'O' || fourth == 'U';
+    return node.substr(0, vowel ? 3 : 4);
+}
+
+// Normalize ':SOURce:VOLTage:MODE' to 'SOUR:VOLT:MODE'
+std::string normalizeHeader(const std::string& header) {
+    if (!header.empty() && header[0] == '*') return upper(header);
+    std::string out;
+    std::size_t start = header[0] == ':' ? 1 : 0;
+    while (start <= header.size()) {
+        std::size_t colon = header.find(':', start);
+        std::string node = upper(header.substr(start, colon - start));
+        if (!out.empty()) out += ':';
+        out += shortForm(node);
+        if (colon == std::string::npos) break;
+        start = colon + 1;
+    }
+    return out;
+}
+
+// Split a program message on ';' outside of quoted strings
+std::vector<std::string> splitUnits(const std::string& line) {
+    std::vector<std::string> units;
+    std::string cur;
+    bool quoted = false;
+    for (char c : line) {
+        if (c == '"') quoted = !quoted;
+        if (c == ';' && !quoted) {
+            units.push_back(cur);
+            cur.clear();
+        } else {
+            cur += c;
+        }
+    }
+    units.push_back(cur);
+    return units;
+}
+
+// Parse 'v1,v2,...'
+std::vector<double> parseList(const std::string& args) {
+    std::vector<double> values;
+    const char* p = args.c_str();
+    while (*p) {
+        char* end = nullptr;
+        double v = std::strtod(p, &end);
+        if (end == p) break;
+        values.push_back(v);
+        p = end;
+        while (*p == ',' || *p == ' ') ++p;
+    }
+    return values;
+}
+
+// ON/1 and OFF/0 booleans
+bool parseBool(const std::string& args) {
+    std::string a = upper(trim(args));
+    return a == "ON" || a == "1";
+}
+
+// Sleep for a (possibly zero) number of seconds
+void pause(double seconds) {
+    if (seconds > 0) std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+} // namespace
+
+// Instrument powers up in its reset state
+ScpiSimulator::ScpiSimulator(const SimConfig& config)
+    : config_(config), listenFd_(-1), boundPort_(0), running_(false), messages_(0),
+      rng_(12345), output_(false), listMode_(false), target_(0.0), previous_(0.0),
+      setTime_(Clock::now()), triggerCount_(1), acqDelay_(0.0), busyUntil_(Clock::now()),
+      binary_(false), swapped_(false), averCount_(1), averOn_(false), frequency_(1000.0), acLevel_(1.0), lcrReadyAt_(Clock::now()),
+      impedanceRange_(std::numeric_limits<int>::min()) {}
+
+// Make sure sockets and threads are released
+ScpiSimulator::~ScpiSimulator() {
+    stop();
+}
+
+int ScpiSimulator::port() const {
+    return boundPort_;
+}
+
+std::size_t ScpiSimulator::messageCount() const {
+    return messages_;
+}
+
+// Open the listening socket
+void ScpiSimulator::listen() {
+    listenFd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0) throw std::runtime_error("Socket creation failed");
+    int one = 1;
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(config_.port);
+    inet_pton(AF_INET, config_.bindAddress.c_str(), &addr.sin_addr);
+    if (bind(listenFd_, (struct sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listenFd_, 16) < 0) {
+        ::close(listenFd_);
+        listenFd_ = -1;
+        throw std::runtime_error("Simulator cannot listen on port " + std::to_string(config_.port) +
+                                 ": " + std::strerror(errno));
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(listenFd_, (struct sockaddr*)&addr, &len);
+    boundPort_ = ntohs(addr.sin_port);
+    running_ = true;
+}
+
+// Listen and accept clients on a background thread
+void ScpiSimulator::start() {
+    if (listenFd_ < 0) listen();
+    acceptThread_ = std::thread(&ScpiSimulator::acceptLoop, this);
+}
+
+// Listen and accept clients on the calling thread
+void ScpiSimulator::serve() {
+    if (listenFd_ < 0) listen();
+    acceptLoop();
+}
+
+// Close the listener, disconnect clients and join all threads
+void ScpiSimulator::stop() {
+    if (!running_.exchange(false)) return;
+    if (acceptThread_.joinable()) acceptThread_.join();
+    if (listenFd_ >= 0) ::close(listenFd_);
+    listenFd_ = -1;
+
+    // Clients close their own sockets on exit, so join them without holding the lock
+    std::vector<std::thread> clients;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        for (int fd : clientFds_)
+            if (fd >= 0) shutdown(fd, SHUT_RDWR);
+        clients.swap(clients_);
+    }
+    for (auto& t : clients) t.join();
+    clientFds_.clear();
+}
+
+// Poll the listener so stop() is noticed promptly
+void ScpiSimulator::acceptLoop() {
+    while (running_) {
+        pollfd pfd{listenFd_, POLLIN, 0};
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        int fd = accept(listenFd_, nullptr, nullptr);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        clientFds_.push_back(fd);
+        clients_.emplace_back(&ScpiSimulator::handleClient, this, fd);
+    }
+}
+
+// Serve one client, then close its socket and forget it
+void ScpiSimulator::handleClient(int fd) {
+    serveClient(fd);
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    std::replace(clientFds_.begin(), clientFds_.end(), fd, -1);
+    ::close(fd);
+}
+
+// Answer one client's program messages line by line
+void ScpiSimulator::serveClient(int fd) {
+    std::string rx;
+    char buffer[4096];
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::mt19937_64 rng(static_cast<unsigned>(fd) * 7919u);
+
+    while (running_) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) break;
+        rx.append(buffer, static_cast<std::size_t>(n));
+
+        std::size_t nl;
+        while ((nl = rx.find('\n')) != std::string::npos) {
+            std::string line = rx.substr(0, nl);
+            rx.erase(0, nl + 1);
+
+            // Fault injection: drop the link instead of answering
+            std::size_t count = ++messages_;
+            if (config_.dropEvery > 0 && count % config_.dropEvery == 0) return;
+
+            double delay = 0.0;
+            std::string reply = execute(trim(line), delay);
+            if (reply.empty()) continue;
+
+            delay += config_.latency + config_.jitter * unit(rng);
+            if (config_.slowProbability > 0 && unit(rng) < config_.slowProbability) delay += config_.slowDelay;
+            pause(delay);
+
+            reply += '\n';
+            std::size_t sent = 0;
+            while (sent < reply.size()) {
+                ssize_t w = send(fd, reply.data() + sent, reply.size() - sent, MSG_NOSIGNAL);
+                if (w <= 0) return;
+                sent += static_cast<std::size_t>(w);
+            }
+        }
+    }
+}
+
+// Run every unit of the message and join their replies with ';'
+std::string ScpiSimulator::execute(const std::string& line, double& delay) {
+    if (line.empty()) return "";
+    std::vector<std::string> replies;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& raw : splitUnits(line)) {
+        std::string unit = trim(raw);
+        if (unit.empty()) continue;
+        std::size_t sp = unit.find_first_of(" \t");
+        std::string header = unit.substr(0, sp);
+        std::string args = sp == std::string::npos ? "" : trim(unit.substr(sp + 1));
+        bool query = header.back() == '?';
+        if (query) header.pop_back();
+        executeUnit(normalizeHeader(header), args, query, replies, delay);
+    }
+
+    std::string out;
+    for (std::size_t i = 0; i < replies.size(); ++i) {
+        if (i) out += ';';
+        out += replies[i];
+    }
+    return out;
+}
+
+// The SCPI subset understood by the simulator
+void ScpiSimulator::executeUnit(const std::string& h, const std::string& args, bool query,
+                                std::vector<std::string>& replies, double& delay) {
+    auto now = Clock::now();
+    auto secondsUntil = [&](Clock::time_point t) {
+        return std::max(0.0, std::chrono::duration<double>(t - now).count());
+    };
+
+    if (h == "*IDN" && query) {
+        replies.push_back(config_.idn);
+    } else if (h == "*RST") {
+        output_ = false;
+        listMode_ = false;
+        target_ = previous_ = 0.0;
+        triggerCount_ = 1;
+        acqDelay_ = 0.0;
+        binary_ = swapped_ = false;
+        averCount_ = 1;
+        averOn_ = false;
+        frequency_ = 1000.0;
+        acLevel_ = 1.0;
+    } else if (h == "*CLS") {
+        errors_.clear();
+    } else if (h == "*WAI") {
+        delay = std::max(delay, secondsUntil(busyUntil_));
+    } else if (h == "*OPC" && query) {
+        // Complete once a running sweep has finished and the output has settled to 0.1 %
+        auto settled = setTime_;
+        if (config_.settleTau > 0)
+            settled += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>(config_.settleTau * std::log(1000.0)));
+        delay = std::max({delay, secondsUntil(busyUntil_), output_ ? secondsUntil(settled) : 0.0});
+        replies.push_back("1");
+    } else if (h == "SYST:ERR" && query) {
+        if (errors_.empty()) {
+            replies.push_back("+0,\"No error\"");
+        } else {
+            replies.push_back(errors_.front());
+            errors_.pop_front();
+        }
+    } else if ((h == "SOUR:VOLT" || h == "SOUR:VOLT:LEV" || h == "BIAS:VOLT") && !query) {
+        previous_ = levelAt(now);
+        target_ = std::strtod(args.c_str(), nullptr);
+        setTime_ = now;
+    } else if ((h == "SOUR:VOLT" || h == "SOUR:VOLT:LEV" || h == "BIAS:VOLT") && query) {
+        replies.push_back(formatReals({target_}));
+    } else if (h == "SOUR:FUNC:MODE" || h == "SENS:FUNC" || h == "TRIG:SOUR" || h == "FUNC:IMP") {
+        // Accepted; the simulator always sources voltage and measures both V and I
+    } else if (h == "SOUR:VOLT:MODE") {
+        if (query) {
+            replies.push_back(listMode_ ? "LIST" : "FIX");
+        } else if (upper(args) == "LIST") {
+            if (config_.listSupport) listMode_ = true;
+            else errors_.push_back("-224,\"Illegal parameter value\"");
+        } else {
+            listMode_ = false;
+        }
+    } else if (h == "SOUR:LIST:VOLT" && config_.listSupport) {
+        if (query) replies.push_back(formatReals(list_));
+        else list_ = parseList(args);
+    } else if (h == "SOUR:LIST:VOLT:POIN" && query && config_.listSupport) {
+        replies.push_back(std::to_string(list_.size()));
+    } else if (h == "TRIG:COUN") {
+        if (query) replies.push_back(std::to_string(triggerCount_));
+        else triggerCount_ = std::max(1, std::atoi(args.c_str()));
+    } else if (h == "TRIG:ACQ:DEL") {
+        if (query) replies.push_back(formatReals({acqDelay_}));
+        else acqDelay_ = std::max(0.0, std::strtod(args.c_str(), nullptr));
+    } else if (h == "OUTP" || h == "BIAS:STAT") {
+        if (query) {
+            replies.push_back(output_ ? "1" : "0");
+        } else {
+            bool on = parseBool(args);
+            if (on && !output_) {
+                previous_ = 0.0;
+                setTime_ = now;
+            }
+            output_ = on;
+        }
+    } else if (h == "INIT") {
+        // Run the whole list (or a single point) and buffer readings for FETCH
+        fetchedVolt_.clear();
+        fetchedCurr_.clear();
+        double level = levelAt(now);
+        int points = listMode_ && !list_.empty() ? triggerCount_ : 1;
+        for (int k = 0; k < points; ++k) {
+            double target = listMode_ && !list_.empty() ? list_[k % list_.size()] : target_;
+            if (!output_) target = 0.0;
+            level = config_.settleTau > 0 ? target + (level - target) * std::exp(-acqDelay_ / config_.settleTau)
+                                          : target;
+            auto [v, i] = reading(level);
+            fetchedVolt_.push_back(v);
+            fetchedCurr_.push_back(i);
+            target_ = target;
+        }
+        double perPoint = acqDelay_ + config_.aperture * (averOn_ ? averCount_ : 1);
+        busyUntil_ = now + std::chrono::duration_cast<Clock::duration>(
+                               std::chrono::duration<double>(points * perPoint));
+        previous_ = level;
+        setTime_ = busyUntil_;
+    } else if ((h == "FETC:ARR:VOLT" || h == "FETC:ARR:CURR") && query) {
+        delay = std::max(delay, secondsUntil(busyUntil_));
+        replies.push_back(formatReals(h == "FETC:ARR:VOLT" ? fetchedVolt_ : fetchedCurr_));
+    } else if ((h == "MEAS:VOLT" || h == "MEAS:CURR") && query) {
+        // With averaging on, the reply is the mean of averCount_ integrations
+        int count = averOn_ ? averCount_ : 1;
+        double sum = 0.0;
+        for (int k = 0; k < count; ++k) {
+            auto [v, i] = reading(levelAt(now));
+            sum += h == "MEAS:VOLT" ? v : i;
+        }
+        delay += config_.aperture * count;
+        replies.push_back(formatReals({sum / count}));
+    } else if (h == "SENS:AVER:COUN" && config_.averagingSupport) {
+        if (query) replies.push_back(std::to_string(averCount_));
+        else averCount_ = std::clamp(std::atoi(args.c_str()), 1, 10000);
+    } else if ((h == "SENS:AVER:STAT" || h == "SENS:AVER") && config_.averagingSupport) {
+        if (query) replies.push_back(averOn_ ? "1" : "0");
+        else averOn_ = parseBool(args);
+    } else if (h == "FREQ" || h == "FREQ:CW") {
+        if (query) {
+            replies.push_back(formatReals({frequency_}));
+        } else {
+            frequency_ = std::max(20.0, std::strtod(args.c_str(), nullptr));
+            lcrReadyAt_ = std::max(lcrReadyAt_, now + std::chrono::duration_cast<Clock::duration>(
+                                                          std::chrono::duration<double>(config_.freqChangeDelay)));
+        }
+    } else if (h == "VOLT" || h == "VOLT:LEV") {
+        if (query) {
+            replies.push_back(formatReals({acLevel_}));
+        } else {
+            acLevel_ = std::max(0.0, std::strtod(args.c_str(), nullptr));
+            lcrReadyAt_ = std::max(lcrReadyAt_, now + std::chrono::duration_cast<Clock::duration>(
+                                                          std::chrono::duration<double>(config_.levelChangeDelay)));
+        }
+    } else if ((h == "FETC" || h == "FETC:IMP") && query) {
+        // Cp, D and status 0, once the test signal has settled
+        delay = std::max(delay, secondsUntil(lcrReadyAt_));
+        auto [cp, d] = impedance(levelAt(now));
+        int range = static_cast<int>(std::floor(std::log10(1.0 / (2.0 * M_PI * frequency_ * cp))));
+        if (range != impedanceRange_ && impedanceRange_ != std::numeric_limits<int>::min())
+            delay += config_.rangeChangeDelay;
+        impedanceRange_ = range;
+        replies.push_back(formatReals({cp, d, 0.0}));
+    } else if (h == "FORM:DATA" || h == "FORM") {
+        if (query) replies.push_back(binary_ ? "REAL,64" : "ASC");
+        else binary_ = upper(args).rfind("REAL", 0) == 0;
+    } else if (h == "FORM:BORD") {
+        if (query) replies.push_back(swapped_ ? "SWAP" : "NORM");
+        else swapped_ = upper(args) == "SWAP";
+    } else {
+        errors_.push_back("-113,\"Undefined header\"");
+    }
+}
+
+// Exponential approach from the previous level to the programmed target
+double ScpiSimulator::levelAt(Clock::time_point t) const {
+    if (!output_) return 0.0;
+    if (config_.settleTau <= 0) return target_;
+    double dt = std::chrono::duration<double>(t - setTime_).count();
+    if (dt <= 0) return previous_;
+    return target_ + (previous_ - target_) * std::exp(-dt / config_.settleTau);
+}
+
+// Device model with current compliance
+double ScpiSimulator::deviceCurrent(double v) const {
+    double i = 0.0;
+    if (config_.model == SimModel::Resistor) {
+        i = config_.resistance > 0 ? v / config_.resistance : 0.0;
+    } else {
+        double x = std::min(v / (config_.ideality * kThermalVoltage), 200.0);
+        i = config_.saturationCurrent * std::expm1(x);
+    }
+    return std::clamp(i, -config_.compliance, config_.compliance);
+}
+
+// Reading with gaussian noise on voltage and current
+std::pair<double, double> ScpiSimulator::reading(double level) {
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    double i = deviceCurrent(level);
+    double v = level * (1.0 + config_.noiseRel * gauss(rng_));
+    i = i * (1.0 + config_.noiseRel * gauss(rng_)) + config_.noiseAbs * gauss(rng_);
+    return {v, i};
+}
+
+// Junction capacitance with a little low-frequency dispersion and AC-level
+// nonlinearity; D from the parallel leakage plus a constant loss floor
+std::pair<double, double> ScpiSimulator::impedance(double bias) {
+    std::normal_distribution<double> gauss(0.0, 1.0);
+    double v = std::min(bias, 0.9 * config_.builtInVoltage);
+    double cp = config_.capacitance / std::sqrt(1.0 - v / config_.builtInVoltage);
+    cp *= 1.0 + 0.1 / (1.0 + frequency_ / 1e4);
+    cp *= 1.0 + 0.01 * acLevel_ * acLevel_;
+    double d = 1.0 / (2.0 * M_PI * frequency_ * cp * config_.parallelResistance) + 1e-4;
+    cp *= 1.0 + config_.noiseRel * gauss(rng_);
+    return {cp, d};
+}
+
+// ASCII list or '#<n><len>' REAL,64 block depending on FORM:DATA
+std::string ScpiSimulator::formatReals(const std::vector<double>& values) const {
+    if (binary_) {
+        std::vector<double> payload(values);
+        ByteOrder order = swapped_ ? ByteOrder::Swapped : ByteOrder::Normal;
+        if (order != nativeByteOrder()) swapReal64(payload.data(), payload.size());
+        std::string len = std::to_string(payload.size() * sizeof(double));
+        return "#" + std::to_string(len.size()) + len +
+               std::string(reinterpret_cast<const char*>(payload.data()), payload.size() * sizeof(double));
+    }
+
+    std::string out;
+    char buf[32];
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        int n = std::snprintf(buf, sizeof(buf), "%+.9E", values[i]);
+        if (i) out += ',';
+        out.append(buf, n);
+    }
+    return out;
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Device under test attached to the simulated source-meter
+enum class SimModel {
+    Resistor,   // I = V / R
+    Diode       // I = Is * (exp(V / (n * Vt)) - 1)
+};
+
+// Behaviour of the simulated instrument
+struct SimConfig {
+    std::string bindAddress = "127.0.0.1";
+    int port = 5025;                       // 0 picks a free port
+    std::string idn = "Keysight Technologies,B2901A,SIM00001,1.0-sim";
+
+    SimModel model = SimModel::Resistor;
+    double resistance = 1000.0;            // Ohm
+    double saturationCurrent = 1e-12;      // Diode Is (A)
+    double ideality = 1.8;                 // Diode n
+    double compliance = 0.1;               // Current limit (A)
+
+    double noiseRel = 0.0;                 // Gaussian noise, relative to the reading
+    double noiseAbs = 0.0;                 // Gaussian noise floor on current (A)
+
+    double latency = 0.0;                  // Seconds before every reply
+    double jitter = 0.0;                   // Uniform extra reply delay up to this (s)
+    double settleTau = 0.0;                // First-order source settling time constant (s)
+
+    bool listSupport = true;               // Accept :SOUR:VOLT:MODE LIST
+    bool averagingSupport = true;          // Accept :SENS:AVER (readings averaged on the instrument)
+    double aperture = 0.0;                 // Integration time of one reading (s)
+    int dropEvery = 0;                     // Close the connection on every Nth message (0 = never)
+    double slowProbability = 0.0;          // Chance a reply is delayed by slowDelay
+    double slowDelay = 0.0;                // Extra delay of a slow reply (s)
+
+    // LCR meter functions: the load is also a junction capacitance biased by the source
+    double capacitance = 100e-12;          // Zero-bias capacitance C0 (F)
+    double builtInVoltage = 0.7;           // Junction potential, C = C0 / sqrt(1 - V / Vbi)
+    double parallelResistance = 1e9;       // Leakage across the junction, sets D (Ohm)
+    double freqChangeDelay = 0.0;          // Reading held back after a frequency change (s)
+    double levelChangeDelay = 0.0;         // Reading held back after an AC level change (s)
+    double rangeChangeDelay = 0.0;         // Extra delay when |Z| moves to another decade range (s)
+};
+
+// Simulated SCPI source-meter served over TCP (raw socket, like port 5025 on the real unit).
+// Implements the subset of SCPI used by MeasurementManager.
+class ScpiSimulator {
+public:
+    explicit ScpiSimulator(const SimConfig& config);
+    ~ScpiSimulator();
+
+    ScpiSimulator(const ScpiSimulator&) = delete;
+    ScpiSimulator& operator=(const ScpiSimulator&) = delete;
+
+    // Bind and listen; port() is then known. Throws if the port cannot be bound.
+    void listen();
+
+    // Bind, listen (unless already listening) and serve clients on a background thread
+    void start();
+
+    // Stop listening and close all client connections
+    void stop();
+
+    // Listen (unless already listening) and serve on the calling thread until stop() is called
+    void serve();
+
+    // Port actually bound (useful when config.port is 0)
+    int port() const;
+
+    // Number of program messages handled so far
+    std::size_t messageCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // Accept connections until stopped
+    void acceptLoop();
+
+    // Client thread body: serve the connection, then close it
+    void handleClient(int fd);
+
+    // Read program messages from one client and answer them
+    void serveClient(int fd);
+
+    // Execute one program message line, return the response (empty if none).
+    // delay receives the time the reply must be held back (settling, *OPC?).
+    std::string execute(const std::string& line, double& delay);
+
+    // Execute one ';'-separated program unit
+    void executeUnit(const std::string& header, const std::string& args, bool query,
+                     std::vector<std::string>& replies, double& delay);
+
+    // Output level at time t following first-order settling
+    double levelAt(Clock::time_point t) const;
+
+    // Current drawn by the device at voltage v (with compliance)
+    double deviceCurrent(double v) const;
+
+    // One noisy V/I reading at the present output level
+    std::pair<double, double> reading(double level);
+
+    // Parallel capacitance and dissipation at the given bias and the present test signal
+    std::pair<double, double> impedance(double bias);
+
+    // Format numbers in the active data format
+    std::string formatReals(const std::vector<double>& values) const;
+
+    SimConfig config_;
+    int listenFd_;
+    int boundPort_;
+    std::atomic<bool> running_;
+    std::thread acceptThread_;
+    std::mutex clientsMutex_;        // Guards clients_ and clientFds_
+    std::vector<std::thread> clients_;
+    std::vector<int> clientFds_;
+    std::atomic<std::size_t> messages_;
+
+    // Instrument state, guarded by mutex_
+    mutable std::mutex mutex_;
+    std::mt19937_64 rng_;
+    bool output_;
+    bool listMode_;
+    double target_;                 // Programmed voltage
+    double previous_;               // Level when the target was last changed
+    Clock::time_point setTime_;
+    std::vector<double> list_;      // :SOUR:LIST:VOLT
+    int triggerCount_;
+    double acqDelay_;               // :TRIG:ACQ:DEL
+    Clock::time_point busyUntil_;   // End of a running list sweep
+    std::vector<double> fetchedVolt_;
+    std::vector<double> fetchedCurr_;
+    bool binary_;
+    bool swapped_;
+    std::deque<std::string> errors_;
+    int averCount_;                 // :SENS:AVER:COUN
+    bool averOn_;                   // :SENS:AVER:STAT
+    double frequency_;              // :FREQ
+    double acLevel_;                // :VOLT (test signal)
+    Clock::time_point lcrReadyAt_;  // Test signal reconfigured and stable
+    int impedanceRange_;            // Decade of |Z| at the last reading
+};
@@ -0,0 +1,136 @@
+#include "settling.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Seconds elapsed since t0
+static double since(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Store configuration and pick up a previously learned table
+SettlingEngine::SettlingEngine(const SettleConfig& config) : config_(config) {
+    if (config_.mode == SettleMode::Table && !config_.tablePath.empty()) loadTable(config_.tablePath);
+}
+
+const SettleConfig& SettlingEngine::config() const {
+    return config_;
+}
+
+// Ranges switch by decade, so group set points by the exponent of |V|
+int SettlingEngine::rangeKey(double voltage) {
+    double mag = std::fabs(voltage);
+    if (mag < 1e-3) return -3;
+    return static_cast<int>(std::floor(std::log10(mag)));
+}
+
+// Wait according to the configured mode and report the time actually used
+SettleResult SettlingEngine::settle(MeasurementManager& meas, double setVoltage) {
+    auto t0 = Clock::now();
+    SettleResult result;
+
+    switch (config_.mode) {
+    case SettleMode::Fixed:
+        std::this_thread::sleep_for(std::chrono::duration<double>(config_.fixedDelay));
+        break;
+
+    case SettleMode::Opc:
+        meas.sendCommand("*OPC?");
+        break;
+
+    case SettleMode::Converge:
+        result = converge(meas);
+        break;
+
+    case SettleMode::Table: {
+        auto it = table_.find(rangeKey(setVoltage));
+        if (it != table_.end()) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(it->second));
+            break;
+        }
+        // Unknown range: learn it once by converging, then reuse the time
+        result = converge(meas);
+        if (result.converged)
+            table_[rangeKey(setVoltage)] = std::min(result.seconds * config_.tableMargin, config_.maxSettle);
+        break;
+    }
+    }
+
+    result.seconds = since(t0);
+    return result;
+}
+
+// Read V/I (or the configured query) until stableReadings consecutive readings agree within tolerance
+SettleResult SettlingEngine::converge(MeasurementManager& meas) {
+    auto t0 = Clock::now();
+    SettleResult result;
+    result.converged = false;
+
+    double last = 0.0;
+    int stable = 0;
+    while (true) {
+        double curr;
+        if (config_.convergeQuery.empty()) {
+            double volt;
+            std::tie(std::ignore, volt, curr) = meas.getBasicMeasurement();
+            result.hasReading = true;
+            result.voltage = volt;
+            result.current = curr;
+        } else {
+            std::vector<double> values = meas.queryReals(config_.convergeQuery);
+            if (values.empty()) throw std::runtime_error("No reading from " + config_.convergeQuery);
+            curr = values[0];
+        }
+        ++result.polls;
+
+        if (result.polls > 1) {
+            double tol = std::max(config_.absTolerance, config_.relTolerance * std::fabs(curr));
+            stable = (std::fabs(curr - last) <= tol) ? stable + 1 : 0;
+            if (stable >= config_.stableReadings - 1) {
+                result.converged = true;
+                break;
+            }
+        }
+        last = curr;
+
+        if (since(t0) + config_.pollInterval > config_.maxSettle) break;
+        std::this_thread::sleep_for(std::chrono::duration<double>(config_.pollInterval));
+    }
+
+    result.seconds = since(t0);
+    return result;
+}
+
+// Table file: one "<range key> <seconds>" pair per line
+void SettlingEngine::loadTable(const std::string& path) {
+    std::ifstream in(path);
+    int key;
+    double seconds;
+    while (in >> key >> seconds) table_[key] = seconds;
+}
+
+// Persist learned settle times for the next run
+void SettlingEngine::saveTable(const std::string& path) const {
+    std::filesystem::path dir = std::filesystem::path(path).parent_path();
+    if (!dir.empty()) std::filesystem::create_directories(dir);
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Failed to write settle table: " + path);
+    for (const auto& [key, seconds] : table_) out << key << " " << seconds << "\n";
+}
+
+// Map the interface value to a settle mode
+SettleMode parseSettleMode(const std::string& name) {
+    if (name.empty() || name == "fixed") return SettleMode::Fixed;
+    if (name == "opc") return SettleMode::Opc;
+    if (name == "auto") return SettleMode::Converge;
+    if (name == "table") return SettleMode::Table;
+    throw std::invalid_argument("Unknown settle mode: " + name);
+}
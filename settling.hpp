@@ -0,0 +1,64 @@
+#pragma once
+#include <map>
+#include <string>
+#include "measurement_manager.hpp"
+
+// How the sweep decides that the source output has settled
+enum class SettleMode {
+    Fixed,      // Sleep a fixed delay
+    Opc,        // Wait on *OPC? until the instrument reports the operation complete
+    Converge,   // Poll the measurement until successive readings agree
+    Table       // Per-range settle times learned from earlier runs
+};
+
+// Tuning knobs for the settling engine
+struct SettleConfig {
+    SettleMode mode = SettleMode::Fixed;
+    double fixedDelay = 0.2;      // Seconds to wait in Fixed mode (also the list-sweep delay)
+    double relTolerance = 1e-3;   // Converge: allowed relative change between readings
+    double absTolerance = 1e-9;   // Converge: absolute floor on the change of the polled reading (A)
+    int stableReadings = 2;       // Converge: consecutive agreeing readings required
+    double pollInterval = 0.005;  // Converge: pause between readings (s)
+    double maxSettle = 2.0;       // Upper bound on any wait (s)
+    double tableMargin = 1.2;     // Table: safety factor applied to learned times
+    std::string tablePath;        // Table: file the learned times are loaded from / saved to
+    std::string convergeQuery;    // Converge: numeric query whose first value is polled (empty: V/I)
+};
+
+// Outcome of waiting for one point
+struct SettleResult {
+    double seconds = 0.0;    // Time actually spent settling
+    int polls = 0;           // Readings taken while converging
+    bool converged = true;   // False if maxSettle was hit first
+    bool hasReading = false; // True if voltage/current hold the final settled reading (V/I polling only)
+    double voltage = 0.0;
+    double current = 0.0;
+};
+
+// Waits for the source to settle after every set point
+class SettlingEngine {
+public:
+    explicit SettlingEngine(const SettleConfig& config);
+
+    // Block until the output set to setVoltage has settled
+    SettleResult settle(MeasurementManager& meas, double setVoltage);
+
+    // Load / store the learned per-range settle table
+    void loadTable(const std::string& path);
+    void saveTable(const std::string& path) const;
+
+    const SettleConfig& config() const;
+
+private:
+    // Poll readings until they stop changing
+    SettleResult converge(MeasurementManager& meas);
+
+    // Decade of |V| used as the range key of the table
+    static int rangeKey(double voltage);
+
+    SettleConfig config_;
+    std::map<int, double> table_;  // range key -> learned settle time (s)
+};
+
+// Parse "fixed", "opc", "auto" or "table" (empty selects fixed)
+SettleMode parseSettleMode(const std::string& name);
@@ -0,0 +1,102 @@
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void RunningStats::add(double x) {
+    ++n_;
+    if (n_ == 1) {
+        min_ = max_ = x;
+    } else {
+        min_ = std::min(min_, x);
+        max_ = std::max(max_, x);
+    }
+    double delta = x - mean_;
+    mean_ += delta / n_;
+    m2_ += delta * (x - mean_);
+}
+
+void RunningStats::clear() {
+    *this = RunningStats();
+}
+
+std::size_t RunningStats::count() const { return n_; }
+double RunningStats::mean() const { return mean_; }
+double RunningStats::variance() const { return n_ > 1 ? m2_ / (n_ - 1) : 0.0; }
+double RunningStats::stddev() const { return std::sqrt(variance()); }
+double RunningStats::standardError() const { return n_ > 0 ? stddev() / std::sqrt(static_cast<double>(n_)) : 0.0; }
+double RunningStats::min() const { return min_; }
+double RunningStats::max() const { return max_; }
+
+namespace {
+
+// Standard normal quantile (Acklam's rational approximation, |error| < 1.2e-9)
+double normalQuantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                               1.383577518672690e+02,  -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                               6.680131188771972e+01,  -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                               -2.549732539343734e+00, 4.374664141464968e+00,  2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                               3.754408661907416e+00};
+    const double low = 0.02425;
+    if (p < low) {
+        double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+               ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+    }
+    if (p > 1 - low) return -normalQuantile(1 - p);
+    double q = p - 0.5, r = q * q;
+    return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+           (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
+} // namespace
+
+// Exact for 1 and 2 degrees of freedom, Cornish-Fisher expansion above
+// (within 1 % at 95 % confidence from dof 3, converging quickly with dof)
+double studentT(double confidence, std::size_t dof) {
+    double p = 0.5 + confidence / 2.0;
+    if (dof == 0) return std::numeric_limits<double>::infinity();
+    if (dof == 1) return std::tan(M_PI * (p - 0.5));
+    if (dof == 2) return (2 * p - 1) / std::sqrt(2 * p * (1 - p));
+    double z = normalQuantile(p), v = static_cast<double>(dof);
+    double z2 = z * z;
+    return z + z * (z2 + 1) / (4 * v) + z * ((5 * z2 + 16) * z2 + 3) / (96 * v * v) +
+           z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * v * v * v);
+}
+
+double confidenceHalfWidth(const RunningStats& stats, double confidence) {
+    if (stats.count() < 2) return std::numeric_limits<double>::infinity();
+    return studentT(confidence, stats.count() - 1) * stats.standardError();
+}
+
+double median(std::vector<double>& values) {
+    if (values.empty()) return 0.0;
+    std::size_t mid = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + mid, values.end());
+    double m = values[mid];
+    if (values.size() % 2 == 0) m = (m + *std::max_element(values.begin(), values.begin() + mid)) / 2.0;
+    return m;
+}
+
+double medianAbsDeviation(const std::vector<double>& values, double center) {
+    std::vector<double> dev;
+    dev.reserve(values.size());
+    for (double v : values) dev.push_back(std::fabs(v - center));
+    return median(dev);
+}
+
+std::size_t rejectOutliers(std::vector<double>& values, double threshold) {
+    if (values.size() < 3 || threshold <= 0) return 0;
+    std::vector<double> sorted(values);
+    double center = median(sorted);
+    double mad = medianAbsDeviation(values, center);
+    if (mad <= 0) return 0;
+    std::size_t before = values.size();
+    values.erase(std::remove_if(values.begin(), values.end(),
+                                [&](double v) { return 0.6745 * std::fabs(v - center) / mad > threshold; }),
+                 values.end());
+    return before - values.size();
+}
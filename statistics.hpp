@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Streaming mean and variance (Welford) with min and max; O(1) memory,
+// numerically stable for long runs of nearly equal readings
+class RunningStats {
+public:
+    void add(double x);
+    void clear();
+
+    std::size_t count() const;
+    double mean() const;
+    double variance() const;        // Sample variance (n - 1), 0 below two readings
+    double stddev() const;
+    double standardError() const;   // stddev / sqrt(n)
+    double min() const;
+    double max() const;
+
+private:
+    std::size_t n_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;               // Sum of squared deviations from the mean
+    double min_ = 0.0;
+    double max_ = 0.0;
+};
+
+// Two-sided Student t critical value, e.g. confidence 0.95 and dof 9 -> 2.262
+double studentT(double confidence, std::size_t dof);
+
+// Half width of the confidence interval of the mean
+double confidenceHalfWidth(const RunningStats& stats, double confidence);
+
+// Median of the values (reorders them)
+double median(std::vector<double>& values);
+
+// Median absolute deviation from center (reorders nothing)
+double medianAbsDeviation(const std::vector<double>& values, double center);
+
+// Drop readings whose modified z-score 0.6745 |x - median| / MAD exceeds
+// threshold; returns the number removed (nothing is removed when MAD is 0)
+std::size_t rejectOutliers(std::vector<double>& values, double threshold = 3.5);
@@ -0,0 +1,206 @@
+#include "sweep.hpp"
+#include "profiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <tuple>
+
+// Build the list of linearly spaced set voltages
+std::vector<double> SweepPlan::voltages() const {
+    std::vector<double> v;
+    if (points <= 0) return v;
+    v.reserve(points);
+    if (points == 1) {
+        v.push_back(vstart);
+        return v;
+    }
+    for (int i = 0; i < points; ++i)
+        v.push_back(vstart + i * (vend - vstart) / (points - 1));
+    return v;
+}
+
+AcquiredPoint AcquiredPoint::stamp(const SweepPoint& p) {
+    using namespace std::chrono;
+    return {p, duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count(),
+            duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count()};
+}
+
+// Set one voltage, wait for stability and measure it
+static SweepPoint measurePoint(MeasurementManager& meas, SettlingEngine& settler, const SweepPlan& plan, int index,
+                               double v) {
+    ScopedTimer pointTimer("sweep.point");
+
+    // Set voltage and enable output on the instrument (no reply, no round trip)
+    {
+        ScopedTimer t("sweep.source");
+        meas.sendBatch({":SOUR:VOLT " + formatReal(v), ":OUTP ON"});
+    }
+
+    // Wait for stability
+    SettleResult settled;
+    {
+        ScopedTimer t("sweep.settle");
+        settled = settler.settle(meas, v);
+    }
+
+    // Averaging samples each quantity until its mean is precise enough (noisy
+    // points take more readings); converging already produced a settled reading;
+    // otherwise measure in one round trip
+    double volt = settled.voltage, curr = settled.current;
+    if (plan.average) {
+        ScopedTimer t("sweep.measure");
+        volt = meas.measureStatistics(":MEAS:VOLT?", plan.averaging).mean;
+        curr = meas.measureStatistics(":MEAS:CURR?", plan.averaging).mean;
+    } else if (!settled.hasReading) {
+        ScopedTimer t("sweep.measure");
+        std::tie(std::ignore, volt, curr) = meas.getBasicMeasurement();
+    }
+    SweepPoint p{index, v, volt, curr, settled.seconds};
+    if (plan.onMeasured) plan.onMeasured(p);
+    return p;
+}
+
+// Set each voltage, wait for stability and measure, one point per iteration
+void runManualSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint) {
+    SettlingEngine settler(plan.settle);
+    auto volts = plan.voltages();
+    for (std::size_t i = static_cast<std::size_t>(std::max(plan.firstPoint, 0)); i < volts.size(); ++i) {
+        SweepPoint p = measurePoint(meas, settler, plan, static_cast<int>(i), volts[i]);
+        ScopedTimer t("sweep.consume");
+        onPoint(p);
+    }
+
+    if (plan.settle.mode == SettleMode::Table && !plan.settle.tablePath.empty())
+        settler.saveTable(plan.settle.tablePath);
+}
+
+// Linear interpolation error of each interval, h^2/8 * |f''| with f'' taken
+// from the second divided differences on either side of the interval
+std::vector<double> interpolationErrors(std::span<const double> x, std::span<const double> y) {
+    std::size_t n = x.size();
+    std::vector<double> err(n > 1 ? n - 1 : 0, 0.0);
+    if (n < 3) return err;
+    std::vector<double> dd2(n, 0.0);  // dd2[i]: second divided difference over (i-1, i, i+1)
+    for (std::size_t i = 1; i + 1 < n; ++i) {
+        double left = (y[i] - y[i - 1]) / (x[i] - x[i - 1]);
+        double right = (y[i + 1] - y[i]) / (x[i + 1] - x[i]);
+        dd2[i] = (right - left) / (x[i + 1] - x[i - 1]);
+    }
+    for (std::size_t i = 0; i + 1 < n; ++i) {
+        double curvature = std::max(i >= 1 ? std::fabs(dd2[i]) : 0.0, i + 2 < n ? std::fabs(dd2[i + 1]) : 0.0);
+        double h = x[i + 1] - x[i];
+        err[i] = h * h / 4.0 * curvature;  // f'' = 2 * dd2
+    }
+    return err;
+}
+
+// Coarse uniform pass, then refinement passes: every interval whose error
+// estimate is above tolerance gets its midpoint measured (worst first while the
+// budget lasts, measured in ascending voltage order to keep source steps short).
+// Points are reported in voltage order once the curve is complete.
+void runAdaptiveSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint) {
+    SettlingEngine settler(plan.settle);
+    int budget = std::max(plan.points, 3);
+    SweepPlan coarse = plan;
+    coarse.points = std::clamp(plan.coarsePoints, 3, budget);
+
+    // A resumed run keeps what was measured; its first points are the start of the coarse pass
+    std::vector<SweepPoint> points(plan.resumed.begin(), plan.resumed.end());  // Sorted by set voltage below
+    int measured = static_cast<int>(points.size());
+    auto coarseVolts = coarse.voltages();
+    for (std::size_t i = points.size(); i < coarseVolts.size(); ++i)
+        points.push_back(measurePoint(meas, settler, plan, measured++, coarseVolts[i]));
+    auto byVoltage = [](const SweepPoint& a, const SweepPoint& b) { return a.setVoltage < b.setVoltage; };
+    std::sort(points.begin(), points.end(), byVoltage);
+
+    double span = std::fabs(plan.vend - plan.vstart);
+    double minStep = span / (4.0 * budget);
+    std::vector<double> x, y;
+    std::vector<std::size_t> split;
+    while (measured < budget) {
+        // Intervals to split in this pass
+        {
+            ScopedTimer t("sweep.refine");
+            x.clear();
+            y.clear();
+            double lo = points[0].current, hi = points[0].current;
+            for (const auto& p : points) {
+                x.push_back(p.setVoltage);
+                y.push_back(p.current);
+                lo = std::min(lo, p.current);
+                hi = std::max(hi, p.current);
+            }
+            double tolerance = std::max(plan.tolerance * (hi - lo), plan.toleranceFloor);
+
+            std::vector<double> err = interpolationErrors(x, y);
+            split.clear();
+            for (std::size_t i = 0; i < err.size(); ++i)
+                if (err[i] > tolerance && x[i + 1] - x[i] > 2.0 * minStep) split.push_back(i);
+
+            std::size_t room = static_cast<std::size_t>(budget - measured);
+            if (split.size() > room) {
+                std::partial_sort(split.begin(), split.begin() + room, split.end(),
+                                  [&](std::size_t a, std::size_t b) { return err[a] > err[b]; });
+                split.resize(room);
+                std::sort(split.begin(), split.end());
+            }
+        }
+        if (split.empty()) break;
+
+        std::vector<SweepPoint> added;
+        for (std::size_t i : split)
+            added.push_back(measurePoint(meas, settler, plan, measured++, 0.5 * (x[i] + x[i + 1])));
+        std::vector<SweepPoint> merged(points.size() + added.size());
+        std::merge(points.begin(), points.end(), added.begin(), added.end(), merged.begin(), byVoltage);
+        points.swap(merged);
+    }
+    profileCount("sweep.adaptive_points", measured);
+
+    if (plan.settle.mode == SettleMode::Table && !plan.settle.tablePath.empty())
+        settler.saveTable(plan.settle.tablePath);
+
+    // Report in the direction the sweep was requested
+    if (plan.vstart > plan.vend) std::reverse(points.begin(), points.end());
+    ScopedTimer t("sweep.consume");
+    for (const auto& p : points) onPoint(p);
+}
+
+// Let the instrument step through the list and hand back all points at the end
+void runListSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint) {
+    auto volts = plan.voltages();
+    std::size_t first = std::min<std::size_t>(std::max(plan.firstPoint, 0), volts.size());
+    volts.erase(volts.begin(), volts.begin() + first);
+    if (volts.empty()) return;
+    std::vector<std::pair<double, double>> readings;
+    {
+        ScopedTimer t("sweep.list_run");
+        readings = meas.listSweep(volts, plan.settle.fixedDelay);
+    }
+    ScopedTimer t("sweep.consume");
+    for (std::size_t i = 0; i < readings.size(); ++i) {
+        SweepPoint p{static_cast<int>(first + i), volts[i], readings[i].first, readings[i].second,
+                     plan.settle.fixedDelay};
+        if (plan.onMeasured) plan.onMeasured(p);
+        onPoint(p);
+    }
+}
+
+// Adaptive plans always run on the host, since each pass depends on the last.
+// Otherwise prefer the list sweep (one reading per point, so not when averaging), fall back to the host loop if the instrument lacks it or rejects it.
+// Only a fixed delay maps onto the instrument's acquisition delay; other settle modes run on the host.
+void runSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint) {
+    if (plan.adaptive) {
+        runAdaptiveSweep(meas, plan, onPoint);
+        return;
+    }
+    if (plan.settle.mode == SettleMode::Fixed && !plan.average && meas.supportsListSweep()) {
+        try {
+            runListSweep(meas, plan, onPoint);
+            return;
+        } catch (const std::runtime_error& e) {
+            std::cerr << "[!] List sweep failed (" << e.what() << "), using point-by-point sweep\n";
+        }
+    }
+    runManualSweep(meas, plan, onPoint);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include "measurement_manager.hpp"
+#include "settling.hpp"
+
+// One measured sweep point
+struct SweepPoint {
+    int index;
+    double setVoltage;
+    double voltage;
+    double current;
+    double settleTime;   // Seconds spent waiting for this point to settle
+};
+
+// Called for every measured point (storage, plotting, ...)
+using PointCallback = std::function<void(const SweepPoint&)>;
+
+// Parameters of a linear voltage sweep
+struct SweepPlan {
+    double vstart = 0.0;
+    double vend = 0.0;
+    int points = 0;
+    SettleConfig settle;        // How long to wait between setting a voltage and measuring it
+
+    // Adaptive sampling: points is the measurement budget, spent where the curve bends
+    bool adaptive = false;
+    int coarsePoints = 9;       // Initial uniform grid
+    double tolerance = 2e-3;    // Allowed linear interpolation error, relative to the current span
+    double toleranceFloor = 1e-9; // Absolute floor on that error (A), so noise on a flat curve is not refined
+
+    // Repeated readings per point until the mean is known to averaging's target
+    bool average = false;
+    AverageOptions averaging;
+
+    // Resuming an interrupted run: uniform sweeps start at point firstPoint,
+    // adaptive sweeps reuse the points in resumed instead of measuring them again
+    int firstPoint = 0;
+    std::vector<SweepPoint> resumed;
+
+    // Called as soon as each new point is measured (adaptive sweeps only report to onPoint at the end)
+    PointCallback onMeasured;
+
+    // Linearly spaced set voltages
+    std::vector<double> voltages() const;
+};
+
+// A sweep point with both clocks read on the acquisition thread, so consumers
+// that run later (storage, export) keep the time it was actually measured
+struct AcquiredPoint {
+    SweepPoint point;
+    std::int64_t monotonicNs;   // steady_clock
+    std::int64_t wallNs;        // system_clock
+
+    static AcquiredPoint stamp(const SweepPoint& p);
+};
+
+// Host-driven sweep: set, wait and measure one point at a time
+void runManualSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint);
+
+// Instrument-driven sweep: program the whole list and fetch all readings at once
+void runListSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint);
+
+// Start from a coarse grid and add midpoints where the interpolation error is
+// above tolerance, until the budget is spent; points arrive in voltage order
+void runAdaptiveSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint);
+
+// Estimated linear interpolation error of each interval of a sampled curve (x ascending)
+std::vector<double> interpolationErrors(std::span<const double> x, std::span<const double> y);
+
+// Adaptive plans sample adaptively; otherwise use the list sweep when the instrument supports it, else the manual loop
+void runSweep(MeasurementManager& meas, const SweepPlan& plan, const PointCallback& onPoint);
@@ -4,70 +4,338 @@
 #include <string>
 #include <filesystem>
 
-int main() {
-    // Initialize ncurses-based user interface
+// Headless: run every job of a job file back to back (concurrent: jobs on
+// different endpoints at the same time), no ncurses
+static int runJobs(const std::string& path, bool concurrent) {
+    std::vector<Job> jobs;
+    try {
+        jobs = parseJobFile(path);
+    } catch (const std::exception& e) {
+        std::cerr << "[!] " << e.what() << std::endl;
+        return 2;
+    }
+
+    std::cout << "[>] " << jobs.size() << " job(s) from " << path << std::endl;
+    JobRunner runner(2, concurrent);
+    std::size_t failed = 0;
+    runner.run(jobs, [&](const JobResult& r) {
+        if (!r.ok) {
+            ++failed;
+            std::cerr << "[!] " << r.name << ": " << r.error << std::endl;
+            return;
+        }
+        std::cout << "[✓] " << r.name << ": " << r.points << " points, acquired in " << r.acquireSeconds
+                  << " s, exported in " << r.exportSeconds << " s";
+        if (r.link.retries) std::cout << " (" << r.link.retries << " retries, " << r.link.timeouts << " timeouts)";
+        std::cout << std::endl;
+        for (const auto& file : r.files) std::cout << "    " << file << std::endl;
+    });
+    std::cout << "[>] " << jobs.size() - failed << "/" << jobs.size() << " job(s) completed over "
+              << runner.connections() << " connection(s)" << std::endl;
+    return failed ? 1 : 0;
+}
+
+// Interface fields of a journaled run, from the metadata written when it started
+static std::map<std::string, std::string> journalParams(const JournalContents& journal) {
+    return {{"Vstart", journal.value("vstart")},
+            {"Vend", journal.value("vend")},
+            {"Points number", journal.value("points")},
+            {"Sampling (uniform/adaptive)", journal.value("sampling")},
+            {"Averaging (max readings)", journal.value("averaging")},
+            {"Settling (fixed/opc/auto/table)", journal.value("settling")},
+            {"Plot (y/n)", journal.value("plot")},
+            {"Save data table (y/n)", journal.value("save")}};
+}
+
+int main(int argc, char** argv) {
+    // Optional instrumentation: KEYSIGHT_PROFILE=1 for a per-phase summary,
+    // KEYSIGHT_TRACE=<file.json> to also write a Chrome trace
+    const char* profileEnv = std::getenv("KEYSIGHT_PROFILE");
+    const char* traceEnv = std::getenv("KEYSIGHT_TRACE");
+    bool profiling = (profileEnv && std::string(profileEnv) == "1") || traceEnv;
+    Profiler::instance().enable(profiling, traceEnv != nullptr);
+
+    // test_interface --jobs <file> [--concurrent]: batch mode
+    if ((argc == 3 || (argc == 4 && std::string(argv[3]) == "--concurrent")) && std::string(argv[1]) == "--jobs") {
+        int status = runJobs(argv[2], argc == 4);
+        if (profiling) {
+            Profiler::instance().writeSummary(std::cout);
+            if (traceEnv) Profiler::instance().writeChromeTrace(traceEnv);
+        }
+        return status;
+    }
+
+    // Prepare save directories
+    const char* home = std::getenv("HOME");
+    std::string saveDataDir = std::string(home) + "/Desktop/data";
+    std::string savePlotDir = std::string(home) + "/Desktop/plots";
+    std::filesystem::create_directories(saveDataDir);
+    std::filesystem::create_directories(savePlotDir);
+
+    // An unfinished journal means an earlier sweep was interrupted; offer to
+    // continue it (test_interface --resume <journal> continues without asking)
     Interface iface;
-    iface.Run();
+    std::string journalFile;
+    if (argc == 3 && std::string(argv[1]) == "--resume") {
+        journalFile = argv[2];
+    } else {
+        std::vector<std::string> unfinished = findUnfinishedJournals(saveDataDir);
+        if (!unfinished.empty()) {
+            std::vector<std::string> items;
+            for (const auto& path : unfinished) {
+                JournalContents j = readJournal(path);
+                items.push_back("Resume " + std::filesystem::path(path).stem().string() + " (" +
+                                std::to_string(j.points.size()) + " points measured)");
+            }
+            items.push_back("Start a new measurement");
+            std::size_t choice = static_cast<std::size_t>(iface.choose(items, "Unfinished sweeps found:"));
+            if (choice < unfinished.size()) journalFile = unfinished[choice];
+        }
+    }
 
-    // Cleanly terminate ncurses UI after parameter input
-    endwin();
+    std::string type;
+    std::map<std::string, std::string> params;
+    JournalContents resume;
+    bool resuming = !journalFile.empty();
+    if (resuming) {
+        try {
+            resume = readJournal(journalFile);
+        } catch (const std::exception& e) {
+            std::cerr << "[!] " << e.what() << std::endl;
+            return 1;
+        }
+        type = resume.value("measurement");
+        params = journalParams(resume);
+    } else {
+        // Initialize ncurses-based user interface
+        iface.Run();
 
-    // Retrieve user-selected measurement type and parameters
-    auto [type, params] = iface.getMeasurementParams();
+        // Cleanly terminate ncurses UI after parameter input
+        endwin();
 
-    // Create connection to measurement instrument (localhost for test)
-    Machine machine("127.0.0.1", 5025);  // Replace with actual IP for real usage
+        // Retrieve user-selected measurement type and parameters
+        std::tie(type, params) = iface.getMeasurementParams();
+    }
+
+    // Create connection to measurement instrument (localhost for test); a resumed
+    // run goes back to the instrument it started on, never splicing in another one
+    std::string host = "127.0.0.1";  // Replace with actual IP for real usage
+    int port = 5025;
+    if (resuming && !resume.value("host").empty()) {
+        host = resume.value("host");
+        port = std::stoi(resume.value("port"));
+    }
+    Machine machine(host, port);
     MeasurementManager meas(machine);
     DataManager data;
     PyPlotter plot;
 
-    // Identify instrument via SCPI *IDN? command
-    std::string idn = std::get<0>(meas.getBasicMeasurement());
+    // Identify instrument via SCPI *IDN? command (cached for the whole run);
+    // a resumed run keeps the identity it started with
+    std::string idn = resume.value("idn");
+    if (!resuming) {
+        try {
+            idn = meas.identify();
+        } catch (const std::runtime_error& e) {
+            std::cerr << "[!] Instrument " << machine.ip() << ":" << machine.port() << " not reachable: " << e.what()
+                      << std::endl;
+            return 1;
+        }
+    }
 
     // Parse user input parameters
-    double vstart = std::stod(params["Vstart"]);
-    double vend = std::stod(params["Vend"]);
-    int points = std::stoi(params["Points number"]);
+    SweepPlan plan = sweepPlanFromParams(params);
     bool doPlot = (params["Plot (y/n)"] == "y" || params["Plot (y/n)"] == "Y");
+
+    // Without a display the live window cannot open; the plot is rendered natively after the sweep
+    bool headless = !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY");
+    bool livePlot = doPlot && !headless;
     bool doSave = (params["Save data table (y/n)"] == "y" || params["Save data table (y/n)"] == "Y");
 
-    // Start Python-based live plotter if selected
-    if (doPlot) plot.startPython();
+    // Capacitance runs a bias x frequency x AC level grid instead of the I-V stream
+    bool capacitance = (type == "Capacitance");
+
+    data.reserve(plan.points);
+
+    // Define output file paths (one CSV per run, never overwritten; a resumed run keeps its own)
+    std::string dataFile = resuming ? resume.value("csv") : uniqueRunPath(saveDataDir, "measurement", "csv");
+    std::string plotFile = livePlot ? savePlotDir + "/plot.png"
+                           : resuming ? resume.value("plot_file")
+                                      : uniqueRunPath(savePlotDir, "plot", "png");
+    if (!resuming) journalFile = journalPathFor(dataFile);
+
+    // Stream rows to disk while the sweep runs, so a crash keeps what was measured.
+    // A resumed run rewrites the file: its journaled points are replayed first.
+    std::unique_ptr<CsvStreamWriter> csv;
+    if (resuming) std::filesystem::remove(dataFile);
+    if (doSave && !capacitance) csv = std::make_unique<CsvStreamWriter>(dataFile);
+
+    // Start Python-based live plotter if selected (long sweeps are sent as
+    // screen-sized min/max snapshots rather than every point)
+    if (livePlot) {
+        plot.enableDecimation();
+        plot.startPython();
+    }
+
+    // Live dashboard on the terminal while the sweep runs (KEYSIGHT_DASHBOARD=0 turns it off);
+    // it draws from its own thread, acquisition only hands it each point
+    const char* dashboardEnv = std::getenv("KEYSIGHT_DASHBOARD");
+    std::unique_ptr<RunDashboard> dashboard;
+    CapacitancePlan cplan;
+    if (capacitance) cplan = capacitancePlanFromParams(params, plan);
+    if (isatty(STDOUT_FILENO) && !(dashboardEnv && std::string(dashboardEnv) == "0")) {
+        DashboardConfig config;
+        config.title = type + " sweep " + params["Vstart"] + " V -> " + params["Vend"] + " V on " + machine.ip() +
+                       ":" + std::to_string(machine.port()) + (resuming ? " (resumed)" : "");
+        config.total = static_cast<std::size_t>(std::max(plan.points, 0));
+        if (capacitance) {
+            config.total = cplan.bias.size() * cplan.frequencies.size() * cplan.acLevels.size();
+            config.labels = {"V", "Cp", "D"};
+        }
+        dashboard = std::make_unique<RunDashboard>(config);
+    }
+
+    if (capacitance) {
+        // Every grid point goes straight into the dense array; the live plot
+        // shows C-V with one curve per frequency / AC level combination
+        if (dashboard) dashboard->start();
+        runCapacitanceSweep(meas, cplan, data, [&](const CapacitancePoint& p) {
+            if (livePlot) {
+                ScopedTimer t("plot.sendPoint");
+                plot.sendPoint(p.bias, p.cp, static_cast<std::uint32_t>(p.index[1] * cplan.acLevels.size() + p.index[2]));
+            }
+            if (dashboard) {
+                dashboard->push({p.bias, p.cp, p.d, 0.0, Profiler::nowNs()});
+                dashboard->setLinkStats(meas.linkStats());
+            }
+        });
+        if (dashboard) dashboard->stop();
+    } else {
+        // Acquisition only stamps each point and queues it; storage, CSV export and
+        // the live plot consume on their own threads so a slow disk or plotter never
+        // stalls the instrument. Storage and export must see every point (block when
+        // full); the plot may skip points rather than hold up the sweep.
+        InstrumentInfo inst = DataManager::parseIdn(idn);
+        Pipeline<AcquiredPoint> pipeline;
+        pipeline.addStage("store", [&](const AcquiredPoint& a) {
+            ScopedTimer t("store.addMeasurement");
+            data.addMeasurement(idn, a.monotonicNs, a.wallNs, a.point.voltage, a.point.current, a.point.settleTime,
+                                a.point.setVoltage);
+        });
+        if (csv) {
+            pipeline.addStage("export", [&](const AcquiredPoint& a) {
+                ScopedTimer t("export.appendRow");
+                csv->appendRow(a.wallNs, inst, a.point.voltage, a.point.current,
+                               DataManager::resistance(a.point.voltage, a.point.current), a.point.settleTime,
+                               a.point.setVoltage);
+            });
+        }
+        if (livePlot) {
+            pipeline.addStage("plot", [&](const AcquiredPoint& a) {
+                ScopedTimer t("plot.sendPoint");
+                plot.sendPoint(a.point.voltage, a.point.current);
+            }, 4096, StagePolicy::Drop);
+        }
+        pipeline.start();
+
+        // Every measured point is journaled, so a crash or a lost instrument
+        // costs only the points since the last journal write
+        std::unique_ptr<SweepJournal> journal;
+        if (resuming) {
+            journal = std::make_unique<SweepJournal>(journalFile, resume);
+        } else {
+            RunMetadata meta = runMetadata(type, params, plan, dataFile);
+            meta.insert(meta.end(), {{"plot", params["Plot (y/n)"]},
+                                     {"save", params["Save data table (y/n)"]},
+                                     {"plot_file", plotFile},
+                                     {"idn", idn},
+                                     {"host", machine.ip()},
+                                     {"port", std::to_string(machine.port())}});
+            journal = std::make_unique<SweepJournal>(journalFile, meta);
+        }
 
-    // Main measurement loop
-    for (int i = 0; i < points; ++i) {
-        double v = vstart + i * (vend - vstart) / (points - 1);  // Linearly spaced voltages
+        // Run the sweep (instrument list mode when available), reconnecting and
+        // continuing from the first missing point if the instrument drops out
+        std::string failure;
+        if (dashboard) dashboard->start();
+        try {
+            runJournaledSweep(meas, plan, *journal, resume.points, [&](const AcquiredPoint& a) {
+                pipeline.push(a);
+                if (dashboard) {
+                    dashboard->push({a.point.voltage, a.point.current,
+                                     DataManager::resistance(a.point.voltage, a.point.current), a.point.settleTime,
+                                     a.monotonicNs});
+                    dashboard->setLinkStats(meas.linkStats());
+                }
+            });
+        } catch (const std::runtime_error& e) {
+            failure = e.what();
+        }
+        if (dashboard) dashboard->stop();
 
-        // Set voltage and enable output on the instrument
-        meas.sendCommand(":SOUR:VOLT " + std::to_string(v));
-        meas.sendCommand(":OUTP ON");
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Wait for stability
+        // Drain every stage before the data is read back. A failed stage (e.g. a full
+        // disk under the CSV export) stops the run like a lost instrument: the
+        // journal holds every point, so the run can be resumed once it is fixed.
+        try {
+            pipeline.finish();
+        } catch (const std::runtime_error& e) {
+            if (failure.empty()) failure = e.what();
+        }
+        profileStageStats(pipeline.stats());
 
-        // Measure voltage and current, calculate resistance, and store
-        auto [_, volt, curr] = meas.getBasicMeasurement();
-        data.addMeasurement(idn, volt, curr);
+        // The journal's last write can fail too (the same full disk); it is then
+        // cut at its last whole record and still resumes from there
+        try {
+            journal->close();
+        } catch (const std::runtime_error& e) {
+            if (failure.empty()) failure = e.what();
+        }
 
-        // Send current to plotter in real time
-        if (doPlot) plot.sendPoint(curr);
+        if (!failure.empty()) {
+            csv.reset();  // Closes without throwing; the journal is what matters here
+            if (livePlot) plot.stopPlotter();
+            std::size_t kept = 0;
+            try {
+                kept = readJournal(journalFile).points.size();
+            } catch (const std::runtime_error&) {
+            }
+            std::cerr << "[!] Sweep stopped after " << kept << " journaled points: " << failure << "\n"
+                      << "    Restart to continue it, or run: test_interface --resume " << journalFile << std::endl;
+            return 1;
+        }
     }
 
     // Terminate plotting process
-    if (doPlot) plot.stopPlotter();
+    if (livePlot) plot.stopPlotter();
 
-    // Prepare save directories
-    const char* home = std::getenv("HOME");
-    std::string saveDataDir = std::string(home) + "/Desktop/data";
-    std::string savePlotDir = std::string(home) + "/Desktop/plots";
-    std::filesystem::create_directories(saveDataDir);
-    std::filesystem::create_directories(savePlotDir);
+    // Headless: draw the IV curve (or C-V curves per frequency at the first AC level) straight to PNG
+    if (doPlot && !livePlot) renderRunPlot(plotFile, data, capacitance);
+
+    // Flush and close the streamed CSV
+    if (csv) {
+        ScopedTimer t("export.close");
+        csv->close();
+    }
+
+    // Binary columnar copy of the run for fast reload and analysis
+    std::string runFile = dataFile.substr(0, dataFile.size() - 4) + ".run";
+    if (doSave && capacitance) {
+        ScopedTimer t("export.grid");
+        data.grid().saveCSV(dataFile);
+    } else if (doSave) {
+        ScopedTimer t("export.runFile");
+        writeRunFile(runFile, data, runMetadata(type, params, plan, dataFile, meas.linkStats()));
+    }
 
-    // Define output file paths
-    std::string dataFile = saveDataDir + "/measurement.csv";
-    std::string plotFile = savePlotDir + "/plot.png";
+    // Everything is on disk; the journal is no longer needed
+    if (!capacitance) std::filesystem::remove(journalFile);
 
-    // Save measurements to CSV if requested
-    if (doSave) {
-        data.saveCSV(dataFile);
+    // Write per-phase timing summary (and trace) of this run
+    std::string profileFile = saveDataDir + "/profile.txt";
+    if (profiling) {
+        std::ofstream summary(profileFile);
+        Profiler::instance().writeSummary(summary);
+        if (traceEnv) Profiler::instance().writeChromeTrace(traceEnv);
     }
 
     // Show final ncurses-based result screen
@@ -79,9 +347,11 @@ int main() {
     clear();
     mvprintw(2, 4, "✓ Measurement completed successfully.");
     mvprintw(4, 4, "Saved to:");
-    mvprintw(5, 6, "• %s", plotFile.c_str());
+    if (doPlot) mvprintw(5, 6, "• %s", plotFile.c_str());
     mvprintw(6, 6, "• %s", dataFile.c_str());
-    mvprintw(8, 4, "Press any key to exit...");
+    if (doSave && !capacitance) mvprintw(7, 6, "• %s", runFile.c_str());
+    if (profiling) mvprintw(8, 6, "• %s", profileFile.c_str());
+    mvprintw(10, 4, "Press any key to exit...");
     refresh();
     getch();
 